@@ -20,10 +20,12 @@ CREATE DATABASE contours
 CREATE TABLE IF NOT EXISTS public.contours
 (
     id_pk integer NOT NULL DEFAULT nextval('contours_id_pk_seq1'::regclass),
-    image_name character varying COLLATE pg_catalog."default",
+    image_path character varying COLLATE pg_catalog."default" NOT NULL,
+    image_name character varying COLLATE pg_catalog."default" NOT NULL,
     contour_numbers integer[],
     contour_names character varying[] COLLATE pg_catalog."default",
-    CONSTRAINT contours_pkey1 PRIMARY KEY (id_pk)
+    CONSTRAINT contours_pkey1 PRIMARY KEY (id_pk),
+    CONSTRAINT contours_image_path_key UNIQUE (image_path)
 )
 
 TABLESPACE pg_default;
@@ -46,4 +48,52 @@ ALTER SEQUENCE public.contours_id_pk_seq1
     OWNED BY public.contours.id_pk;
 
 ALTER SEQUENCE public.contours_id_pk_seq1
-    OWNER TO postgres;
\ No newline at end of file
+    OWNER TO postgres;
+
+-- Table: public.contour
+
+-- DROP TABLE IF EXISTS public.contour;
+
+CREATE TABLE IF NOT EXISTS public.contour
+(
+    image_id integer NOT NULL,
+    "number" integer NOT NULL,
+    name character varying COLLATE pg_catalog."default" NOT NULL DEFAULT '',
+    bbox_x integer NOT NULL,
+    bbox_y integer NOT NULL,
+    bbox_width integer NOT NULL,
+    bbox_height integer NOT NULL,
+    area double precision NOT NULL,
+    CONSTRAINT contour_pkey PRIMARY KEY (image_id, "number"),
+    CONSTRAINT contour_image_id_fkey FOREIGN KEY (image_id)
+        REFERENCES public.contours (id_pk)
+        ON DELETE CASCADE
+)
+
+TABLESPACE pg_default;
+
+ALTER TABLE IF EXISTS public.contour
+    OWNER to postgres;
+
+CREATE INDEX IF NOT EXISTS contour_area_idx
+    ON public.contour USING btree (area);
+
+-- Table: public.contour_geometry
+
+-- DROP TABLE IF EXISTS public.contour_geometry;
+
+CREATE TABLE IF NOT EXISTS public.contour_geometry
+(
+    image_hash character varying COLLATE pg_catalog."default" NOT NULL,
+    image_name character varying COLLATE pg_catalog."default" NOT NULL,
+    image_height integer NOT NULL,
+    image_width integer NOT NULL,
+    contour_count integer NOT NULL,
+    contour_geometry bytea NOT NULL,
+    CONSTRAINT contour_geometry_pkey PRIMARY KEY (image_hash, image_height, image_width)
+)
+
+TABLESPACE pg_default;
+
+ALTER TABLE IF EXISTS public.contour_geometry
+    OWNER to postgres;
\ No newline at end of file
@@ -0,0 +1,65 @@
+-- Upgrade: indexed image key and normalized contour rows.
+-- Run once against a database created with an earlier contoursDB.sql.
+
+BEGIN;
+
+-- Table: public.contours
+
+-- Images are keyed by their canonical path, as files in different folders
+-- can share a name.
+ALTER TABLE IF EXISTS public.contours
+    ADD COLUMN IF NOT EXISTS image_path character varying COLLATE pg_catalog."default";
+
+UPDATE public.contours SET image_name = '' WHERE image_name IS NULL;
+
+-- Earlier rows have no path. They are keyed by their name, which the app
+-- still looks them up by until the image is saved again.
+UPDATE public.contours SET image_path = image_name WHERE image_path IS NULL;
+
+-- Earlier versions could store a name more than once. Older rows are kept
+-- under a key of their own rather than deleted.
+UPDATE public.contours older
+    SET image_path = older.image_path || '#' || older.id_pk
+    FROM public.contours newer
+    WHERE older.image_path = newer.image_path
+      AND older.id_pk < newer.id_pk;
+
+ALTER TABLE IF EXISTS public.contours
+    ALTER COLUMN image_path SET NOT NULL;
+
+ALTER TABLE IF EXISTS public.contours
+    ALTER COLUMN image_name SET NOT NULL;
+
+-- Lookups and upserts match image_path exactly through this index.
+ALTER TABLE IF EXISTS public.contours
+    ADD CONSTRAINT contours_image_path_key UNIQUE (image_path);
+
+-- Table: public.contour
+
+-- One row per saved contour, so single contours can be queried without
+-- unpacking the arrays of public.contours.
+CREATE TABLE IF NOT EXISTS public.contour
+(
+    image_id integer NOT NULL,
+    "number" integer NOT NULL,
+    name character varying COLLATE pg_catalog."default" NOT NULL DEFAULT '',
+    bbox_x integer NOT NULL,
+    bbox_y integer NOT NULL,
+    bbox_width integer NOT NULL,
+    bbox_height integer NOT NULL,
+    area double precision NOT NULL,
+    CONSTRAINT contour_pkey PRIMARY KEY (image_id, "number"),
+    CONSTRAINT contour_image_id_fkey FOREIGN KEY (image_id)
+        REFERENCES public.contours (id_pk)
+        ON DELETE CASCADE
+)
+
+TABLESPACE pg_default;
+
+ALTER TABLE IF EXISTS public.contour
+    OWNER to postgres;
+
+CREATE INDEX IF NOT EXISTS contour_area_idx
+    ON public.contour USING btree (area);
+
+COMMIT;
@@ -0,0 +1,35 @@
+-- Upgrade: contour geometry keyed by image content hash and the size it was
+-- detected at, as an image opened scaled down and at full resolution has two.
+-- Run once against a database upgraded with contoursDB_upgrade_1.sql.
+
+BEGIN;
+
+-- Table: public.contour_geometry
+
+-- DROP TABLE IF EXISTS public.contour_geometry;
+
+CREATE TABLE IF NOT EXISTS public.contour_geometry
+(
+    image_hash character varying COLLATE pg_catalog."default" NOT NULL,
+    image_name character varying COLLATE pg_catalog."default" NOT NULL,
+    image_height integer NOT NULL,
+    image_width integer NOT NULL,
+    contour_count integer NOT NULL,
+    contour_geometry bytea NOT NULL,
+    CONSTRAINT contour_geometry_pkey PRIMARY KEY (image_hash, image_height, image_width)
+)
+
+TABLESPACE pg_default;
+
+ALTER TABLE IF EXISTS public.contour_geometry
+    OWNER to postgres;
+
+-- Tables created by an earlier version of this script were keyed by the hash
+-- alone.
+ALTER TABLE IF EXISTS public.contour_geometry
+    DROP CONSTRAINT IF EXISTS contour_geometry_pkey;
+
+ALTER TABLE IF EXISTS public.contour_geometry
+    ADD CONSTRAINT contour_geometry_pkey PRIMARY KEY (image_hash, image_height, image_width);
+
+COMMIT;
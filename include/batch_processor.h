@@ -0,0 +1,45 @@
+#ifndef BATCH_PROCESSOR_H_
+#define BATCH_PROCESSOR_H_
+
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "contour_store.h"
+
+struct BatchOptions {
+  std::string output_dir{"."};
+  size_t thread_count{0};     // 0 means one thread per core
+  int max_height{0};          // 0 means detection runs at full resolution
+  int tile_rows{0};           // 0 means detection runs on the whole image
+  std::string cache_dir{};    // empty means results are not cached
+  std::string archive_path{}; // empty means no archive is written
+};
+
+// Stage timings are summed over all worker threads.
+struct BatchReport {
+  size_t images_processed{0};
+  size_t images_failed{0};
+  size_t contours_found{0};
+  size_t cache_hits{0};
+  bool archive_written{false};
+  double wall_seconds{0.0};
+  double decode_seconds{0.0};
+  double detect_seconds{0.0};
+  double write_seconds{0.0};
+};
+
+// An image and where its result goes, relative to the output directory.
+struct BatchImage {
+  std::string path{};
+  std::string output_name{};
+};
+
+std::vector<BatchImage> collectImagePaths(const std::vector<std::string> &inputs);
+BatchReport runBatch(const std::vector<BatchImage> &images,
+                     const BatchOptions &options);
+
+bool writeContoursFile(const std::string &file_path,
+                       const ContourStore &contours);
+
+#endif // BATCH_PROCESSOR_H_
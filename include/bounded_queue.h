@@ -0,0 +1,75 @@
+#ifndef BOUNDED_QUEUE_H_
+#define BOUNDED_QUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Queue between the stages of a pipeline. Pushing blocks while the queue is
+// full, so a fast stage cannot run ahead of a slow one by more than the
+// capacity. Closing it lets consumers drain what is left and stop.
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity)
+      : m_capacity{capacity > 0 ? capacity : 1} {}
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /**
+   * @brief Adds an item, waiting for room.
+   *
+   * @return false if the queue has been closed, the item is then dropped.
+   */
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_not_full.wait(
+        lock, [this]() { return m_closed || m_items.size() < m_capacity; });
+    if (m_closed) {
+      return false;
+    }
+    m_items.push_back(std::move(item));
+    lock.unlock();
+    m_not_empty.notify_one();
+
+    return true;
+  }
+
+  /**
+   * @brief Takes the oldest item, waiting for one.
+   *
+   * @return false once the queue is closed and empty.
+   */
+  bool pop(T &item) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_not_empty.wait(lock, [this]() { return m_closed || !m_items.empty(); });
+    if (m_items.empty()) {
+      return false;
+    }
+    item = std::move(m_items.front());
+    m_items.pop_front();
+    lock.unlock();
+    m_not_full.notify_one();
+
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      m_closed = true;
+    }
+    m_not_full.notify_all();
+    m_not_empty.notify_all();
+  }
+
+private:
+  const size_t m_capacity;
+  std::mutex m_mutex{};
+  std::condition_variable m_not_full{};
+  std::condition_variable m_not_empty{};
+  std::deque<T> m_items{};
+  bool m_closed{false};
+};
+
+#endif // BOUNDED_QUEUE_H_
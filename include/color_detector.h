@@ -0,0 +1,219 @@
+#ifndef COLOR_DETECTOR_H_
+#define COLOR_DETECTOR_H_
+
+#include <array>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "color_mask.h"
+#include "contour_store.h"
+#include "profiler.h"
+
+// Inclusive bounds in OpenCV's 8-bit HSV space: hue is within [0, 180],
+// saturation and value are within [0, 255].
+struct HsvRange {
+  int hue_min{0};
+  int hue_max{180};
+  int saturation_min{0};
+  int saturation_max{255};
+  int value_min{0};
+  int value_max{255};
+
+  constexpr bool contains(int h, int s, int v) const {
+    return h >= hue_min && h <= hue_max && s >= saturation_min &&
+           s <= saturation_max && v >= value_min && v <= value_max;
+  }
+};
+
+// Elliptical kernel sizes of the opening and the closing, 0 disables a step.
+struct MorphologySettings {
+  int open_size{5};
+  int close_size{9};
+};
+
+struct ColorClass {
+  std::string name{};
+  std::vector<HsvRange> ranges{};
+};
+
+// Buffers of a detection kept for the next one, so that detecting image after
+// image on a thread allocates only for an image larger than the previous one
+// or holding more contours. Not to be shared between threads.
+struct DetectionScratch {
+  cv::Mat mask{};
+  cv::Mat morphology{};
+  // The image converted to HSV, for masks computed from it.
+  cv::Mat hsv{};
+  std::vector<std::vector<cv::Point>> contours{};
+};
+
+void applyMorphology(cv::Mat &mask, const MorphologySettings &morphology);
+void applyMorphology(cv::Mat &mask, const MorphologySettings &morphology,
+                     cv::Mat &buffer);
+ContourStore findExternalContours(const cv::Mat &mask);
+void findExternalContours(const cv::Mat &mask, DetectionScratch &scratch,
+                          ContourStore &contours);
+
+// Fixed presets. Their ranges are known at compile time, which lets
+// detectPreset() unroll the range checks, and a preset can replace the HSV
+// based mask with a dedicated kernel, as RedPreset does.
+template <typename Preset> struct HsvPreset {
+  static void computeMask(const cv::Mat &rgb, cv::Mat &mask);
+  static void computeMask(const cv::Mat &rgb, cv::Mat &mask,
+                          cv::Mat &hsv_image);
+};
+
+struct RedPreset {
+  // Color red in HSV color space has both 0 and 180 hue value,
+  // so to get all of red's shades two ranges are needed.
+  static constexpr std::array<HsvRange, 2> kRanges{
+      {{0, 4, 90, 255, 90, 255}, {176, 180, 90, 255, 90, 255}}};
+  static constexpr MorphologySettings kMorphology{5, 9};
+
+  static void computeMask(const cv::Mat &rgb, cv::Mat &mask) {
+    computeRedMask(rgb, mask);
+  }
+};
+
+struct GreenPreset : HsvPreset<GreenPreset> {
+  static constexpr std::array<HsvRange, 1> kRanges{{{35, 85, 90, 255, 90, 255}}};
+  static constexpr MorphologySettings kMorphology{5, 9};
+};
+
+struct BluePreset : HsvPreset<BluePreset> {
+  static constexpr std::array<HsvRange, 1> kRanges{
+      {{100, 130, 90, 255, 90, 255}}};
+  static constexpr MorphologySettings kMorphology{5, 9};
+};
+
+struct YellowPreset : HsvPreset<YellowPreset> {
+  static constexpr std::array<HsvRange, 1> kRanges{{{20, 34, 90, 255, 90, 255}}};
+  static constexpr MorphologySettings kMorphology{5, 9};
+};
+
+template <typename Preset> constexpr bool inPresetRanges(int h, int s, int v) {
+  for (const HsvRange &range : Preset::kRanges) {
+    if (range.contains(h, s, v)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Computes the mask of a preset, with the HSV image in a buffer of its
+ *        own.
+ */
+template <typename Preset>
+void HsvPreset<Preset>::computeMask(const cv::Mat &rgb, cv::Mat &mask) {
+  cv::Mat hsv_image{};
+  computeMask(rgb, mask, hsv_image);
+}
+
+/**
+ * @brief Computes the mask of a preset from the image converted to HSV in one
+ *        call, which lets OpenCV vectorize and parallelize the conversion.
+ *
+ * @param rgb 8-bit RGB image;
+ * @param mask Receives the mask;
+ * @param hsv_image Buffer for the HSV image, reused if large enough.
+ */
+template <typename Preset>
+void HsvPreset<Preset>::computeMask(const cv::Mat &rgb, cv::Mat &mask,
+                                    cv::Mat &hsv_image) {
+  CV_Assert(rgb.type() == CV_8UC3);
+  mask.create(rgb.rows, rgb.cols, CV_8UC1);
+
+  cv::cvtColor(rgb, hsv_image, cv::COLOR_RGB2HSV);
+  for (int y = 0; y != rgb.rows; ++y) {
+    const uchar *hsv{hsv_image.ptr<uchar>(y)};
+    uchar *dst{mask.ptr<uchar>(y)};
+    for (int x = 0; x != rgb.cols; ++x) {
+      dst[x] = inPresetRanges<Preset>(hsv[3 * x], hsv[3 * x + 1],
+                                      hsv[3 * x + 2])
+                   ? 255
+                   : 0;
+    }
+  }
+}
+
+/**
+ * @brief Detects the contours of a fixed preset's color, in buffers kept from
+ *        the previous detection.
+ *
+ * @param rgb 8-bit RGB image;
+ * @param scratch Buffers of the previous detection on this thread;
+ * @param contours Receives the contours with their features, its storage is
+ *        reused.
+ */
+template <typename Preset>
+void detectPreset(const cv::Mat &rgb, DetectionScratch &scratch,
+                  ContourStore &contours) {
+  {
+    PROFILE_SCOPE("color mask");
+    if constexpr (std::is_base_of_v<HsvPreset<Preset>, Preset>) {
+      Preset::computeMask(rgb, scratch.mask, scratch.hsv);
+    } else {
+      Preset::computeMask(rgb, scratch.mask);
+    }
+  }
+  applyMorphology(scratch.mask, Preset::kMorphology, scratch.morphology);
+  findExternalContours(scratch.mask, scratch, contours);
+}
+
+/**
+ * @brief Detects the contours of a fixed preset's color.
+ *
+ * @param rgb 8-bit RGB image.
+ * @return The contours with their features.
+ */
+template <typename Preset> ContourStore detectPreset(const cv::Mat &rgb) {
+  DetectionScratch scratch{};
+  ContourStore contours{};
+  detectPreset<Preset>(rgb, scratch, contours);
+
+  return contours;
+}
+
+template <typename Preset> ColorClass presetColorClass(std::string name) {
+  return ColorClass{std::move(name), std::vector<HsvRange>(
+                                         Preset::kRanges.begin(),
+                                         Preset::kRanges.end())};
+}
+
+// Runtime-configurable detector. Classifies every pixel against all color
+// classes in a single HSV pass, then extracts each class's contours.
+class ColorRangeDetector {
+public:
+  static constexpr size_t kMaxClasses{8};
+  static constexpr size_t kMaxRanges{32};
+
+  explicit ColorRangeDetector(std::vector<ColorClass> color_classes,
+                              MorphologySettings morphology = {});
+
+  const std::vector<ColorClass> &colorClasses() const {
+    return m_color_classes;
+  }
+  const MorphologySettings &morphology() const { return m_morphology; }
+
+  void computeLabelMask(const cv::Mat &rgb, cv::Mat &labels) const;
+  void computeLabelMask(const cv::Mat &rgb, cv::Mat &labels,
+                        cv::Mat &hsv_image) const;
+  std::vector<ContourStore> detect(const cv::Mat &rgb) const;
+
+private:
+  std::vector<ColorClass> m_color_classes{};
+  MorphologySettings m_morphology{};
+
+  // Bit i of an entry is set if the channel value fits range i.
+  std::array<uint32_t, 256> m_hue_lut{};
+  std::array<uint32_t, 256> m_saturation_lut{};
+  std::array<uint32_t, 256> m_value_lut{};
+  // Per class, the bits of the ranges belonging to it.
+  std::vector<uint32_t> m_class_ranges{};
+};
+
+#endif // COLOR_DETECTOR_H_
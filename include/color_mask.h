@@ -0,0 +1,8 @@
+#ifndef COLOR_MASK_H_
+#define COLOR_MASK_H_
+
+#include <opencv2/opencv.hpp>
+
+void computeRedMask(const cv::Mat &rgb, cv::Mat &mask);
+
+#endif // COLOR_MASK_H_
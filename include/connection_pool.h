@@ -0,0 +1,60 @@
+#ifndef CONNECTION_POOL_H_
+#define CONNECTION_POOL_H_
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <pqxx/pqxx>
+#include <string>
+#include <thread>
+#include <vector>
+
+class ConnectionPool {
+public:
+  // Exclusive use of a pooled connection, given back when the lease ends.
+  class Lease {
+  public:
+    Lease(ConnectionPool &pool, std::unique_ptr<pqxx::connection> conn)
+        : m_pool{&pool}, m_conn{std::move(conn)} {}
+    ~Lease();
+
+    Lease(Lease &&) = default;
+    Lease &operator=(Lease &&) = delete;
+    Lease(const Lease &) = delete;
+    Lease &operator=(const Lease &) = delete;
+
+    pqxx::connection &operator*() const { return *m_conn; }
+    pqxx::connection *operator->() const { return m_conn.get(); }
+
+  private:
+    ConnectionPool *m_pool;
+    std::unique_ptr<pqxx::connection> m_conn;
+  };
+
+  explicit ConnectionPool(std::string conn_string, size_t max_size = 4);
+  ~ConnectionPool();
+
+  ConnectionPool(const ConnectionPool &) = delete;
+  ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+  Lease acquire();
+  void connectInBackground();
+
+private:
+  std::unique_ptr<pqxx::connection> connect();
+  void release(std::unique_ptr<pqxx::connection> conn);
+
+  const std::string m_conn_string;
+  const size_t m_max_size;
+
+  std::mutex m_mutex{};
+  std::condition_variable m_released{};
+  // Guarded by m_mutex. m_open counts idle, leased and connecting
+  // connections.
+  std::vector<std::unique_ptr<pqxx::connection>> m_idle{};
+  size_t m_open{0};
+
+  std::thread m_background_connect{};
+};
+
+#endif // CONNECTION_POOL_H_
@@ -0,0 +1,119 @@
+#ifndef CONTOUR_ARCHIVE_H_
+#define CONTOUR_ARCHIVE_H_
+
+#include <QFile>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "contour_store.h"
+
+// Contours of many images in one file, read in place through a memory map.
+// The file holds, in this order and 8-byte aligned:
+//   ArchiveHeader;
+//   ArchiveImage per image, sorted by name;
+//   ArchiveContour per contour, the contours of an image following each other;
+//   point runs, encoded as by encodeContours: the first point relative to the
+//   contour's bounding box, the others relative to the previous point;
+//   image names, UTF-8 without terminators.
+// Fields are in the byte order of the machine that wrote the file, which is
+// little-endian on every platform built for; a reader of the other byte order
+// sees a wrong version and rejects the file.
+
+struct ArchiveHeader {
+  char magic[4]{'C', 'T', 'R', 'A'};
+  uint32_t version{1};
+  uint64_t image_count{0};
+  uint64_t contour_count{0};
+  uint64_t points_offset{0};
+  uint64_t points_size{0};
+  uint64_t names_offset{0};
+  uint64_t names_size{0};
+};
+
+struct ArchiveImage {
+  // Into the names.
+  uint64_t name_offset{0};
+  uint32_t name_size{0};
+  int32_t height{0};
+  int32_t width{0};
+  uint32_t reserved{0};
+  uint64_t first_contour{0};
+  uint64_t contour_count{0};
+};
+
+// The features are kept next to the points, for filtering without decoding.
+struct ArchiveContour {
+  // Into the point runs.
+  uint64_t points_offset{0};
+  uint32_t points_size{0};
+  uint32_t point_count{0};
+  int32_t x{0};
+  int32_t y{0};
+  int32_t width{0};
+  int32_t height{0};
+  double area{0.0};
+  double perimeter{0.0};
+};
+
+static_assert(sizeof(ArchiveHeader) == 56, "archive layout");
+static_assert(sizeof(ArchiveImage) == 40, "archive layout");
+static_assert(sizeof(ArchiveContour) == 48, "archive layout");
+
+// Collects the contours of images, then writes them as one archive.
+class ContourArchiveWriter {
+public:
+  void add(const std::string &name, int img_height, int img_width,
+           const ContourStore &contours);
+  bool write(const std::string &file_path) const;
+
+  size_t imageCount() const { return m_images.size(); }
+
+private:
+  // Point runs are encoded as images are added; only the offsets are left
+  // for writing.
+  struct Image {
+    std::string name{};
+    int height{0};
+    int width{0};
+    std::vector<ArchiveContour> contours{};
+    std::vector<uint8_t> points{};
+  };
+
+  std::vector<Image> m_images{};
+};
+
+// Read-only view of an archive file. Opening checks the header and the
+// tables; records are then read where they lie in the mapped file, and point
+// runs are decoded only when asked for.
+class ContourArchive {
+public:
+  ContourArchive() = default;
+  ContourArchive(const ContourArchive &) = delete;
+  ContourArchive &operator=(const ContourArchive &) = delete;
+
+  bool open(const std::string &file_path);
+  void close();
+
+  size_t imageCount() const;
+  size_t contourCount() const;
+  const ArchiveImage &image(size_t index) const { return m_images[index]; }
+  std::string_view imageName(size_t index) const;
+  const ArchiveContour &contour(size_t index) const {
+    return m_contours[index];
+  }
+
+  bool readPoints(size_t contour_index, std::vector<cv::Point> &points) const;
+  bool readImage(size_t image_index, ContourStore &contours) const;
+
+private:
+  QFile m_file{};
+  const uint8_t *m_data{nullptr};
+  const ArchiveHeader *m_header{nullptr};
+  const ArchiveImage *m_images{nullptr};
+  const ArchiveContour *m_contours{nullptr};
+};
+
+#endif // CONTOUR_ARCHIVE_H_
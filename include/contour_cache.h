@@ -0,0 +1,55 @@
+#ifndef CONTOUR_CACHE_H_
+#define CONTOUR_CACHE_H_
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "contour_store.h"
+
+// On-disk cache of detected contours, one file per entry, bounded in size.
+// Entries are evicted least recently used first; recency survives restarts
+// through the files' modification times. Safe to use from several threads.
+class ContourCache {
+public:
+  explicit ContourCache(const std::string &directory,
+                        uint64_t max_bytes = 64ull << 20);
+
+  ContourCache(const ContourCache &) = delete;
+  ContourCache &operator=(const ContourCache &) = delete;
+
+  static std::string makeKey(const std::string &image_hash,
+                             const std::string &parameters, int img_height,
+                             int img_width);
+
+  bool get(const std::string &key, ContourStore &contours);
+  void put(const std::string &key, const ContourStore &contours);
+
+  uint64_t sizeBytes();
+
+private:
+  struct Entry {
+    std::list<std::string>::iterator recency{};
+    uint64_t size{0};
+  };
+
+  std::filesystem::path entryPath(const std::string &key) const;
+  void erase(const std::string &key);
+  void evict();
+
+  const std::filesystem::path m_directory;
+  const uint64_t m_max_bytes;
+
+  std::mutex m_mutex{};
+  // Guarded by m_mutex. Most recently used keys first.
+  std::list<std::string> m_recency{};
+  std::unordered_map<std::string, Entry> m_entries{};
+  uint64_t m_size{0};
+};
+
+#endif // CONTOUR_CACHE_H_
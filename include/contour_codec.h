@@ -0,0 +1,25 @@
+#ifndef CONTOUR_CODEC_H_
+#define CONTOUR_CODEC_H_
+
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "contour_store.h"
+
+std::vector<uint8_t> encodeContours(const ContourStore &contours);
+bool decodeContours(const uint8_t *data, size_t size, ContourStore &contours);
+
+void writeVarint(std::vector<uint8_t> &out, uint64_t value);
+bool readVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value);
+
+inline uint64_t zigzagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^
+         static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+#endif // CONTOUR_CODEC_H_
@@ -1,27 +1,25 @@
 #ifndef CONTOUR_DETECTION_H_
 #define CONTOUR_DETECTION_H_
 
-#include <QPixmap>
+#include <QColor>
+#include <QImage>
 #include <opencv2/opencv.hpp>
 
-cv::Mat fromQPixmapToCvMat(QPixmap &pixmap);
-QPixmap fromCvMatToQPixmap(cv::Mat mat);
+#include "color_detector.h"
+#include "contour_store.h"
 
-std::vector<std::vector<cv::Point>> getContourVector(cv::Mat mat);
+cv::Mat wrapQImageAsCvMat(const QImage &image);
 
-cv::Mat drawAllContours(const std::vector<std::vector<cv::Point>> &contours,
-                        int img_height, int img_width);
-cv::Mat drawSavedContours(const std::vector<std::vector<cv::Point>> &contours,
-                          int img_height, int img_width,
-                          const std::vector<int> &rows);
-cv::Mat drawHighlights(const std::vector<std::vector<cv::Point>> &contours,
-                       int img_height, int img_width,
-                       const std::vector<int> &rows);
+ContourStore getContourVector(cv::Mat mat);
+void getContourVector(const cv::Mat &img, DetectionScratch &scratch,
+                      ContourStore &contours);
+std::string contourDetectorParameters();
 
-cv::Scalar hueToBgraCvScalar(int hue, int alpha);
 QColor hueToRgbaQColor(int hue, int alpha);
 
-int clickedContourNumber(const std::vector<std::vector<cv::Point>> &contours,
-                         int x, int y);
+int clickedContourNumber(const ContourStore &contours, int x, int y);
+cv::Mat buildContourLabelMap(const ContourStore &contours, int img_height,
+                             int img_width);
+int clickedContourNumber(const cv::Mat &label_map, int x, int y);
 
 #endif // CONTOUR_DETECTION_H_
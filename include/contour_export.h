@@ -0,0 +1,11 @@
+#ifndef CONTOUR_EXPORT_H_
+#define CONTOUR_EXPORT_H_
+
+#include <string>
+
+#include "contour_archive.h"
+
+bool exportGeoJson(const ContourArchive &archive, const std::string &file_path);
+bool exportCsv(const ContourArchive &archive, const std::string &file_path);
+
+#endif // CONTOUR_EXPORT_H_
@@ -0,0 +1,34 @@
+#ifndef CONTOUR_FILTER_H_
+#define CONTOUR_FILTER_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "contour_store.h"
+
+// Bounds on the features of the contours to list. A bound of 0 is not
+// applied.
+struct ContourFilter {
+  double min_area{0.0};
+  double max_area{0.0};
+  // Bounding box width over height.
+  double min_aspect_ratio{0.0};
+  double max_aspect_ratio{0.0};
+  double min_solidity{0.0};
+  // Only contours whose bounding box intersects it, unless it is empty.
+  cv::Rect region{};
+};
+
+enum class ContourOrder {
+  Detection,
+  AreaDescending,
+  AreaAscending,
+  PerimeterDescending,
+  TopToBottom
+};
+
+std::vector<int> filterContours(const ContourStore &contours,
+                                const ContourFilter &filter,
+                                ContourOrder order);
+
+#endif // CONTOUR_FILTER_H_
@@ -0,0 +1,43 @@
+#ifndef CONTOUR_FILTER_PANEL_H_
+#define CONTOUR_FILTER_PANEL_H_
+
+#include <QCheckBox>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QPushButton>
+#include <QWidget>
+
+#include "contour_filter.h"
+
+// Controls of the filter and the order of the found contours. Every change
+// is reported at once; the panel holds no contours itself.
+class ContourFilterPanel : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit ContourFilterPanel(QWidget *parent = Q_NULLPTR);
+  ~ContourFilterPanel();
+
+  ContourFilter filter() const;
+  ContourOrder order() const;
+  bool limitedToView() const;
+
+signals:
+  void filterChanged();
+
+private:
+  void resetFilter();
+  void reportChange();
+
+  QDoubleSpinBox *min_area_box;
+  QDoubleSpinBox *max_area_box;
+  QDoubleSpinBox *min_aspect_box;
+  QDoubleSpinBox *max_aspect_box;
+  QDoubleSpinBox *min_solidity_box;
+  QCheckBox *in_view_check;
+  QComboBox *order_combo;
+  QPushButton *reset_button;
+  bool m_resetting{false};
+};
+
+#endif // CONTOUR_FILTER_PANEL_H_
@@ -0,0 +1,82 @@
+#ifndef CONTOUR_LIST_MODEL_H_
+#define CONTOUR_LIST_MODEL_H_
+
+#include <QAbstractTableModel>
+#include <QItemSelection>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Single-column list of contours. Rows are not stored as items: labels and
+// colors are computed when the view asks for the rows it shows.
+class ContourListModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  explicit ContourListModel(QString title, QObject *parent = Q_NULLPTR);
+
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role = Qt::DisplayRole) const override;
+
+  virtual int contourNumber(int row) const = 0;
+  std::vector<int> contourNumbers(const QItemSelection &selection) const;
+
+protected:
+  QVariant contourColor(int row) const;
+
+private:
+  QString m_title{};
+};
+
+// Contours found on the image that pass the filter, in the chosen order.
+class FoundContoursModel : public ContourListModel {
+  Q_OBJECT
+
+public:
+  explicit FoundContoursModel(QObject *parent = Q_NULLPTR);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+
+  static QString contourLabel(int number);
+  int contourNumber(int row) const override { return m_numbers[row]; }
+  int contourRow(int number) const;
+  const std::vector<int> &listedContours() const { return m_numbers; }
+  void setContourNumbers(std::vector<int> numbers);
+
+private:
+  std::vector<int> m_numbers{};
+  // Row of every contour number, -1 for the contours not listed.
+  std::vector<int> m_rows{};
+};
+
+// Contours picked to be saved, in the order they were added, with their
+// user-editable names.
+class SavedContoursModel : public ContourListModel {
+  Q_OBJECT
+
+public:
+  explicit SavedContoursModel(QObject *parent = Q_NULLPTR);
+
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index,
+                int role = Qt::DisplayRole) const override;
+  bool setData(const QModelIndex &index, const QVariant &value,
+               int role = Qt::EditRole) override;
+  Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+  int contourNumber(int row) const override { return m_rows[row].first; }
+  const std::vector<std::pair<int, std::string>> &contours() const {
+    return m_rows;
+  }
+  void setContours(std::vector<std::pair<int, std::string>> contours);
+  void appendContours(const std::vector<std::pair<int, std::string>> &contours);
+  void removeContours(const QItemSelection &selection);
+
+private:
+  std::vector<std::pair<int, std::string>> m_rows{};
+};
+
+#endif // CONTOUR_LIST_MODEL_H_
@@ -0,0 +1,79 @@
+#ifndef CONTOUR_STORE_H_
+#define CONTOUR_STORE_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// Points of one contour, borrowed from the store holding them.
+struct ContourPoints {
+  const cv::Point *data{nullptr};
+  size_t size{0};
+
+  const cv::Point *begin() const { return data; }
+  const cv::Point *end() const { return data + size; }
+  const cv::Point &front() const { return data[0]; }
+  const cv::Point &operator[](size_t i) const { return data[i]; }
+
+  cv::Mat mat() const;
+};
+
+// Contours as a structure of arrays: the points of all contours in one
+// buffer, delimited by offsets, next to per-contour features computed once
+// when the contour is added. Filtering or sorting by a feature reads a single
+// contiguous array, and a store of any size holds a fixed number of heap
+// blocks, which clear() and assign() keep for the next image.
+class ContourStore {
+public:
+  ContourStore() = default;
+  explicit ContourStore(const std::vector<std::vector<cv::Point>> &contours);
+
+  void assign(const std::vector<std::vector<cv::Point>> &contours);
+  void reserve(size_t contour_count, size_t point_count);
+  void append(const cv::Point *points, size_t count);
+  void append(const std::vector<cv::Point> &contour) {
+    append(contour.data(), contour.size());
+  }
+  void append(const ContourStore &other, size_t index);
+  void clear();
+
+  size_t size() const { return m_bboxes.size(); }
+  bool empty() const { return m_bboxes.empty(); }
+  size_t pointCount() const { return m_points.size(); }
+
+  ContourPoints operator[](size_t index) const {
+    return {m_points.data() + m_offsets[index],
+            m_offsets[index + 1] - m_offsets[index]};
+  }
+  std::vector<cv::Mat> mats() const;
+
+  const cv::Rect &bbox(size_t index) const { return m_bboxes[index]; }
+  double area(size_t index) const { return m_areas[index]; }
+  double perimeter(size_t index) const { return m_perimeters[index]; }
+  double solidity(size_t index) const { return m_solidities[index]; }
+  const cv::Point2d &centroid(size_t index) const {
+    return m_centroids[index];
+  }
+  const cv::Moments &moments(size_t index) const { return m_moments[index]; }
+
+  const std::vector<cv::Point> &points() const { return m_points; }
+  const std::vector<size_t> &offsets() const { return m_offsets; }
+  const std::vector<cv::Rect> &bboxes() const { return m_bboxes; }
+  const std::vector<double> &areas() const { return m_areas; }
+  const std::vector<double> &perimeters() const { return m_perimeters; }
+  const std::vector<double> &solidities() const { return m_solidities; }
+  const std::vector<cv::Point2d> &centroids() const { return m_centroids; }
+
+private:
+  std::vector<cv::Point> m_points{};
+  // Contour i spans [m_offsets[i], m_offsets[i + 1]) of m_points.
+  std::vector<size_t> m_offsets{0};
+  std::vector<cv::Rect> m_bboxes{};
+  std::vector<double> m_areas{};
+  std::vector<double> m_perimeters{};
+  // Area over the area of the convex hull.
+  std::vector<double> m_solidities{};
+  std::vector<cv::Point2d> m_centroids{};
+  std::vector<cv::Moments> m_moments{};
+};
+
+#endif // CONTOUR_STORE_H_
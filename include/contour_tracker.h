@@ -0,0 +1,51 @@
+#ifndef CONTOUR_TRACKER_H_
+#define CONTOUR_TRACKER_H_
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "contour_store.h"
+
+struct TrackerOptions {
+  // A contour continues a track if its bounding box overlaps the track's
+  // predicted one by this much (intersection over union)...
+  double min_iou{0.3};
+  // ...or if its centroid is this close to the predicted centroid, in pixels.
+  double max_centroid_distance{20.0};
+  // Frames a track survives without a matching contour.
+  int max_missed_frames{5};
+};
+
+struct TrackedContour {
+  int track_id{-1};
+  // Whether the contour starts its track in this frame.
+  bool is_new{false};
+};
+
+// Gives the contours of consecutive frames ids that stay the same for the
+// same object. Tracks move at the velocity of their last match, which keeps
+// fast objects matched; matching is greedy, best overlap first.
+class ContourTracker {
+public:
+  explicit ContourTracker(TrackerOptions options = {});
+
+  std::vector<TrackedContour> update(const ContourStore &contours);
+
+  size_t activeTrackCount() const { return m_tracks.size(); }
+  int tracksStarted() const { return m_next_id; }
+
+private:
+  struct Track {
+    int id{0};
+    cv::Rect bbox{};
+    cv::Point2d centroid{};
+    cv::Point2d velocity{};
+    int missed{0};
+  };
+
+  TrackerOptions m_options{};
+  std::vector<Track> m_tracks{};
+  int m_next_id{0};
+};
+
+#endif // CONTOUR_TRACKER_H_
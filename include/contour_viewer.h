@@ -0,0 +1,101 @@
+#ifndef CONTOUR_VIEWER_H_
+#define CONTOUR_VIEWER_H_
+
+#include <QGraphicsItem>
+#include <QGraphicsPixmapItem>
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QMouseEvent>
+#include <QResizeEvent>
+#include <QWheelEvent>
+#include <array>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "contour_store.h"
+
+// A contour drawn as a vector shape in image coordinates. At low zoom it is
+// drawn from a Douglas-Peucker simplification of itself, computed once per
+// level of detail and cached. The points are borrowed from the viewer's
+// contour store.
+class ContourItem : public QGraphicsItem {
+public:
+  ContourItem(ContourPoints contour, const cv::Rect &bbox, int number);
+
+  QRectF boundingRect() const override;
+  void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+             QWidget *widget = Q_NULLPTR) override;
+
+  void setOutlined(bool outlined);
+  void setListed(bool listed);
+  void setSaved(bool saved);
+  void setHighlighted(bool highlighted);
+
+private:
+  // Level 0 is the contour itself, every next level allows twice the error.
+  static constexpr int kLevels{8};
+
+  const QPolygonF &polygon(int level);
+  void updateVisibility();
+
+  ContourPoints m_contour{};
+  std::array<QPolygonF, kLevels> m_levels{};
+  std::array<bool, kLevels> m_level_ready{};
+  QRectF m_bounds{};
+  QColor m_color{};
+  bool m_outlined{false};
+  bool m_listed{true};
+  bool m_saved{false};
+  bool m_highlighted{false};
+};
+
+// Zoomable view of an image and its contours. Only the contours within the
+// viewport are painted. Dragging pans; the wheel zooms around the cursor.
+class ContourViewer : public QGraphicsView {
+  Q_OBJECT
+
+public:
+  explicit ContourViewer(QWidget *parent = Q_NULLPTR);
+  ~ContourViewer();
+
+  void setImage(const QImage &image);
+  void setContours(const ContourStore &contours);
+  void clear();
+  void fitImage();
+  QRect visibleImageRect() const;
+
+  void setOutlinesVisible(bool visible);
+  void setListedContours(const std::vector<int> &numbers);
+  void setSavedContours(const std::vector<int> &numbers);
+  void setHighlightedContours(const std::vector<int> &numbers);
+
+signals:
+  // Positions are image pixels.
+  void lmbClicked(const QPoint &image_pos);
+  void rmbClicked(const QPoint &image_pos, const QPoint &global_pos);
+  void visibleAreaChanged();
+
+protected:
+  void wheelEvent(QWheelEvent *event);
+  void mousePressEvent(QMouseEvent *event);
+  void mouseMoveEvent(QMouseEvent *event);
+  void mouseReleaseEvent(QMouseEvent *event);
+  void resizeEvent(QResizeEvent *event);
+  void scrollContentsBy(int dx, int dy);
+
+private:
+  QPoint imagePos(const QPoint &view_pos) const;
+
+  QGraphicsScene *m_scene;
+  QGraphicsPixmapItem *m_image_item;
+  ContourStore m_contours{};
+  std::vector<ContourItem *> m_items{};
+  std::vector<int> m_saved{};
+  std::vector<int> m_highlighted{};
+  bool m_outlines_visible{false};
+
+  QPoint m_press_pos{};
+  bool m_panning{false};
+};
+
+#endif // CONTOUR_VIEWER_H_
@@ -0,0 +1,10 @@
+#ifndef IMAGE_HASH_H_
+#define IMAGE_HASH_H_
+
+#include <QByteArray>
+#include <string>
+
+std::string hashImageData(const QByteArray &data);
+std::string hashImageFile(const std::string &file_path);
+
+#endif // IMAGE_HASH_H_
@@ -1,40 +1,94 @@
 #ifndef MAIN_WINDOW_H_
 #define MAIN_WINDOW_H_
 
+#include <QFile>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QHBoxLayout>
 #include <QHeaderView>
 #include <QMainWindow>
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QPushButton>
-#include <QStackedWidget>
-#include <QTableWidget>
+#include <QStandardPaths>
+#include <QTableView>
+#include <QtConcurrent>
 #include <iostream>
 #include <opencv2/opencv.hpp>
 #include <pqxx/pqxx>
 
 
-#include "clickable_label.h"
+#include "connection_pool.h"
+#include "contour_cache.h"
+#include "contour_filter_panel.h"
+#include "contour_list_model.h"
+#include "contour_store.h"
+#include "contour_viewer.h"
+#include "stats_panel.h"
+
+// Image loading runs off the GUI thread and reports its stages one by one.
+struct ImageLoadResult {
+  enum Stage { Decoded, Detected };
+
+  Stage stage{Decoded};
+  QImage image{};
+  std::string image_hash{};
+  ContourStore contours{};
+  cv::Mat contour_label_map{};
+  // Whether the contours come from the cache or the database rather than
+  // detection.
+  bool from_store{false};
+};
+
+// Saved contours of the image being loaded. A failed fetch is told apart
+// from an image without saved contours.
+struct SavedContoursResult {
+  bool loaded{false};
+  std::vector<std::pair<int, std::string>> contours{};
+  std::string error{};
+};
+
+// Outcome of saving contours, which runs off the GUI thread.
+struct SaveResult {
+  enum Status { Saved, Unavailable, Failed };
+
+  Status status{Saved};
+  std::string error{};
+};
 
 class MainWindow : public QMainWindow {
   Q_OBJECT
 
 public:
   MainWindow();
+  ~MainWindow();
 
 private slots:
   void openImage();
   void exitApp();
   void selectClickedContours(const QPoint &click_pos);
   void showAddContextMenuTable(const QPoint &click_pos);
-  void showAddContextMenuLabel(const QPoint &click_pos);
+  void showAddContextMenuViewer(const QPoint &image_pos,
+                                const QPoint &global_pos);
   void showDeleteContextMenu(const QPoint &click_pos);
+  void showStatsPanel();
 
 private:
   void closeEvent(QCloseEvent *event);
 
   void establishDbConnection();
+  void startImageLoad();
+  void loadImage(QPromise<ImageLoadResult> &promise, const QString &image_path,
+                 int max_height);
+  bool loadStoredGeometry(const std::string &image_hash, int img_height,
+                          int img_width,
+                          ContourStore &contours);
+  void fetchSavedContours();
+  void cancelImageLoad();
+  void handleImageLoadResult(int index);
+  void handleSavedContoursLoaded();
+  void handleContoursSaved();
+  void updateSaveButton();
   void createWidgets();
   void createTables();
   void createActions();
@@ -44,41 +98,65 @@ private:
                   QMessageBox::Icon icon);
 
   void fillFoundContoursTable();
-  void fillContoursToAddTable();
+  void applyContourFilter();
+  void fillContoursToAddTable(
+      const std::vector<std::pair<int, std::string>> &saved_contours);
   void displayAllContours();
   void displaySavedContours();
   void addContours();
   void deleteContours();
   void saveContours();
-  std::vector<int> getSelectedContourNum(const QTableWidget &table);
+  std::vector<int> getSelectedContourNum(const QTableView &table);
+
+  // pqxx connections are not thread-safe; the GUI and the workers each lease
+  // their own.
+  std::unique_ptr<ConnectionPool> m_db_pool{};
+  std::unique_ptr<ContourCache> m_contour_cache{};
 
-  std::unique_ptr<pqxx::connection> m_conn{};
+  QFutureWatcher<ImageLoadResult> *m_image_load_watcher;
+  QFutureWatcher<SavedContoursResult> *m_saved_contours_watcher;
+  QFutureWatcher<SaveResult> *m_save_watcher;
+  bool m_contours_ready{false};
+  bool m_saved_contours_ready{false};
 
   QString m_image_path{};
   QString m_image_name{};
+  // Identifies the image's saved contours; the name alone is not unique.
+  QString m_canonical_path{};
+  std::string m_image_hash{};
   int m_image_height{};
   int m_image_width{};
-  std::vector<std::vector<cv::Point>> m_found_contours{};
+  ContourStore m_found_contours{};
+  // Contour number + 1 per pixel, used for hit-testing clicks.
+  cv::Mat m_contour_label_map{};
   std::unordered_map<int, std::string> m_saved_contours{};
   bool m_table_has_changed{false};
+  // Counts changes to the saved contours table, so that a save finishing
+  // after further changes does not mark them as saved.
+  unsigned m_table_revision{0};
+  unsigned m_saving_revision{0};
+  QString m_saving_image_path{};
 
   QWidget *central_widget;
-  QStackedWidget *stacked_labels;
-  QLabel *image_label;
-  QLabel *saved_contour_label;
-  ClickableLabel *found_contour_label;
-  QLabel *highlight_label;
+  ContourViewer *contour_viewer;
   QPushButton *show_contours_button;
   QPushButton *save_contours_button;
+  ContourFilterPanel *filter_panel;
 
-  QTableWidget *found_contours_table;
-  QTableWidget *saved_contours_table;
+  QTableView *found_contours_table;
+  QTableView *saved_contours_table;
+  FoundContoursModel *m_found_model;
+  SavedContoursModel *m_saved_model;
+  StatsPanel *stats_panel{nullptr};
 
   QAction *open_action;
   QAction *exit_action;
   QAction *add_action;
   QAction *delete_action;
+  QAction *stats_action;
+  QAction *full_resolution_action;
   QMenu *file_menu;
+  QMenu *view_menu;
   QMenu *add_context_menu;
   QMenu *delete_context_menu;
 };
@@ -0,0 +1,148 @@
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Timings of the named stages of the pipeline and of named counters, kept
+// as running statistics and as a bounded trace exportable to the Chrome
+// trace format (chrome://tracing, Perfetto).
+//
+// Code is instrumented with PROFILE_SCOPE and PROFILE_COUNTER, which compile
+// to nothing unless CONTOURS_PROFILING is defined (CMake option
+// CONTOURS_ENABLE_PROFILING). Names have to be string literals.
+//
+// Every thread records into its own buffer, keyed by the names' addresses,
+// so recording neither contends with other threads nor allocates once a
+// name has been seen. Buffers are merged by name when statistics or the
+// trace are read.
+
+struct StageStats {
+  std::string name{};
+  uint64_t count{0};
+  double last_ms{0.0};
+  double total_ms{0.0};
+  double max_ms{0.0};
+};
+
+struct CounterStats {
+  std::string name{};
+  uint64_t count{0};
+  int64_t last{0};
+  int64_t total{0};
+};
+
+class Profiler {
+public:
+  using Clock = std::chrono::steady_clock;
+
+#ifdef CONTOURS_PROFILING
+  static constexpr bool kEnabled{true};
+#else
+  static constexpr bool kEnabled{false};
+#endif
+
+  static Profiler &instance();
+
+  void recordScope(const char *name, Clock::time_point start,
+                   Clock::time_point end);
+  void recordCounter(const char *name, int64_t value);
+
+  std::vector<StageStats> stageStats();
+  std::vector<CounterStats> counterStats();
+  bool writeChromeTrace(const std::string &file_path);
+  void reset();
+
+private:
+  Profiler();
+
+  // A scope when duration_us is non-negative, a counter sample otherwise.
+  struct TraceEvent {
+    const char *name{nullptr};
+    uint32_t thread{0};
+    int64_t start_us{0};
+    int64_t duration_us{0};
+    int64_t value{0};
+  };
+
+  // Statistics of one name, with the time of its last sample so that the
+  // latest one wins when threads are merged.
+  struct StageTotals {
+    uint64_t count{0};
+    double last_ms{0.0};
+    double total_ms{0.0};
+    double max_ms{0.0};
+    int64_t last_us{0};
+  };
+
+  struct CounterTotals {
+    uint64_t count{0};
+    int64_t last{0};
+    int64_t total{0};
+    int64_t last_us{0};
+  };
+
+  // What one thread has recorded. Its mutex is only contended while the
+  // buffer is being read.
+  struct ThreadBuffer {
+    std::mutex mutex{};
+    std::unordered_map<const char *, StageTotals> stages{};
+    std::unordered_map<const char *, CounterTotals> counters{};
+    std::vector<TraceEvent> events{};
+    size_t next_event{0};
+  };
+
+  // Oldest events are overwritten once the trace is full.
+  static constexpr size_t kMaxEvents{1 << 16};
+  static constexpr size_t kMaxThreadEvents{1 << 14};
+
+  ThreadBuffer &threadBuffer();
+  void retire(ThreadBuffer *buffer);
+  static void addEvent(ThreadBuffer &buffer, const TraceEvent &event,
+                       size_t max_events);
+  static void mergeStage(StageTotals &into, const StageTotals &from);
+  static void mergeCounter(CounterTotals &into, const CounterTotals &from);
+
+  std::mutex m_mutex{};
+  // Guarded by m_mutex, which is taken before any buffer's mutex. Buffers of
+  // threads that have ended are folded into m_retired.
+  std::vector<std::unique_ptr<ThreadBuffer>> m_buffers{};
+  ThreadBuffer m_retired{};
+};
+
+// Records the time from its construction to its destruction.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(const char *name)
+      : m_name{name}, m_start{Profiler::Clock::now()} {}
+  ~ScopedTimer() {
+    Profiler::instance().recordScope(m_name, m_start,
+                                     Profiler::Clock::now());
+  }
+
+  ScopedTimer(const ScopedTimer &) = delete;
+  ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+private:
+  const char *m_name;
+  Profiler::Clock::time_point m_start;
+};
+
+#ifdef CONTOURS_PROFILING
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(name)                                                    \
+  ScopedTimer PROFILE_CONCAT(profile_scope_, __LINE__) { name }
+#define PROFILE_COUNTER(name, value)                                           \
+  Profiler::instance().recordCounter(name, static_cast<int64_t>(value))
+#else
+#define PROFILE_SCOPE(name) static_cast<void>(0)
+#define PROFILE_COUNTER(name, value) static_cast<void>(0)
+#endif
+
+#endif // PROFILER_H_
@@ -0,0 +1,25 @@
+#ifndef PYRAMID_DETECTION_H_
+#define PYRAMID_DETECTION_H_
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+#include "color_detector.h"
+#include "contour_store.h"
+
+struct PyramidOptions {
+  // Side of the square of full resolution pixels one coarse pixel covers.
+  int block_size{8};
+  // Share of the image the regions may cover before the whole image is
+  // refined instead.
+  double max_region_share{0.5};
+};
+
+ContourStore
+detectPyramid(const cv::Mat &rgb, const PyramidOptions &options,
+              const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+              const MorphologySettings &morphology);
+ContourStore getContourVectorPyramid(const cv::Mat &rgb,
+                                     const PyramidOptions &options = {});
+
+#endif // PYRAMID_DETECTION_H_
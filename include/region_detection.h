@@ -0,0 +1,28 @@
+#ifndef REGION_DETECTION_H_
+#define REGION_DETECTION_H_
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "color_detector.h"
+#include "contour_store.h"
+
+struct RegionDetection {
+  ContourStore contours{};
+  // New number of every previous contour, -1 for the contours replaced.
+  std::vector<int> renumbered{};
+  // Area that has been detected again, in image pixels.
+  cv::Rect region{};
+};
+
+RegionDetection
+redetectRegion(const cv::Mat &rgb, const ContourStore &previous,
+               const cv::Rect &dirty,
+               const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+               const MorphologySettings &morphology);
+RegionDetection getContourVectorRegion(const cv::Mat &rgb,
+                                       const ContourStore &previous,
+                                       const cv::Rect &dirty);
+
+#endif // REGION_DETECTION_H_
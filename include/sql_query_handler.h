@@ -3,10 +3,60 @@
 
 #include <pqxx/pqxx>
 
-void addContoursToDb(
-    pqxx::connection &conn, const std::string &image_name,
-    const std::unordered_map<int, std::string> &contours_to_add);
+// Geometry of a contour, stored in the normalized contour table.
+struct ContourSummary {
+  int bbox_x{0};
+  int bbox_y{0};
+  int bbox_width{0};
+  int bbox_height{0};
+  double area{0.0};
+};
+
+// Saved contours of one image, for the batch functions.
+struct ImageContours {
+  // Canonical path, which identifies the image.
+  std::string image_path{};
+  std::string image_name{};
+  std::unordered_map<int, std::string> contours{};
+  // Geometry of all found contours, indexed by contour number.
+  std::vector<ContourSummary> summaries{};
+};
+
+void prepareStatements(pqxx::connection &conn);
+
+bool addContoursToDb(
+    pqxx::connection &conn, const std::string &image_path,
+    const std::string &image_name,
+    const std::unordered_map<int, std::string> &contours_to_add,
+    const std::vector<ContourSummary> &summaries = {});
+void writeContours(pqxx::work &work, const std::string &image_path,
+                   const std::string &image_name,
+                   const std::unordered_map<int, std::string> &contours_to_add,
+                   const std::vector<ContourSummary> &summaries);
+void insertContourRows(pqxx::work &work, int image_id,
+                       const std::unordered_map<int, std::string> &contours,
+                       const std::vector<ContourSummary> &summaries);
 std::vector<std::pair<int, std::string>>
-getContoursFromDb(pqxx::connection &conn, const std::string &image_name);
+getContoursFromDb(pqxx::connection &conn, const std::string &image_path,
+                  const std::string &image_name);
+
+bool addContourGeometryToDb(pqxx::connection &conn,
+                            const std::string &image_hash,
+                            const std::string &image_name, int img_height,
+                            int img_width, int contour_count,
+                            const std::vector<uint8_t> &geometry);
+void writeContourGeometry(pqxx::work &work, const std::string &image_hash,
+                          const std::string &image_name, int img_height,
+                          int img_width, int contour_count,
+                          const std::vector<uint8_t> &geometry);
+bool getContourGeometryFromDb(pqxx::connection &conn,
+                              const std::string &image_hash, int img_height,
+                              int img_width, std::vector<uint8_t> &geometry);
+
+bool addContoursToDbBatch(pqxx::connection &conn,
+                          const std::vector<ImageContours> &images);
+std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>
+getContoursFromDbBatch(pqxx::connection &conn,
+                       const std::vector<std::string> &image_paths);
 
 #endif // SQL_QUERY_HANDLER_H_
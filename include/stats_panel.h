@@ -0,0 +1,36 @@
+#ifndef STATS_PANEL_H_
+#define STATS_PANEL_H_
+
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QWidget>
+
+// Window listing the Profiler's stage timings and counters, refreshed while
+// it is shown, with the trace export.
+class StatsPanel : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit StatsPanel(QWidget *parent = Q_NULLPTR);
+  ~StatsPanel();
+
+protected:
+  void showEvent(QShowEvent *event);
+  void hideEvent(QHideEvent *event);
+
+private:
+  void refresh();
+  void resetStats();
+  void exportTrace();
+
+  QLabel *status_label;
+  QTableWidget *stages_table;
+  QTableWidget *counters_table;
+  QPushButton *reset_button;
+  QPushButton *export_button;
+  QTimer *refresh_timer;
+};
+
+#endif // STATS_PANEL_H_
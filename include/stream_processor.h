@@ -0,0 +1,30 @@
+#ifndef STREAM_PROCESSOR_H_
+#define STREAM_PROCESSOR_H_
+
+#include <string>
+
+#include "contour_tracker.h"
+
+struct StreamOptions {
+  std::string output_dir{"."};
+  size_t thread_count{0};    // 0 means one detection thread per core
+  int max_height{0};         // 0 means detection runs at full resolution
+  size_t queue_capacity{8};  // frames waiting between two stages
+  TrackerOptions tracker{};
+};
+
+// Stage timings are summed over all threads of a stage.
+struct StreamReport {
+  size_t frames_processed{0};
+  size_t frames_failed{0};
+  size_t contours_found{0};
+  size_t tracks_started{0};
+  double wall_seconds{0.0};
+  double decode_seconds{0.0};
+  double detect_seconds{0.0};
+  double track_seconds{0.0};
+};
+
+StreamReport runStream(const std::string &source, const StreamOptions &options);
+
+#endif // STREAM_PROCESSOR_H_
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+  explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(std::function<void()> task);
+  void wait();
+  size_t threadCount() const { return m_workers.size(); }
+
+private:
+  // Every worker owns a queue. Workers take tasks from the back of their own
+  // queue and steal from the front of the others' when theirs runs dry.
+  struct WorkQueue {
+    std::mutex mutex{};
+    std::deque<std::function<void()>> tasks{};
+  };
+
+  void workerLoop(size_t index);
+  bool popTask(size_t index, std::function<void()> &task);
+
+  std::vector<std::unique_ptr<WorkQueue>> m_queues{};
+  std::vector<std::thread> m_workers{};
+
+  std::mutex m_mutex{};
+  std::condition_variable m_task_available{};
+  std::condition_variable m_all_done{};
+  // Guarded by m_mutex. m_queued can dip below zero for a moment when a
+  // worker pops a task before submit() has counted it.
+  long m_queued{0};
+  size_t m_unfinished{0};
+  std::atomic<size_t> m_next_queue{0};
+  bool m_stopping{false};
+};
+
+#endif // THREAD_POOL_H_
@@ -0,0 +1,43 @@
+#ifndef TILED_DETECTION_H_
+#define TILED_DETECTION_H_
+
+#include <functional>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "color_detector.h"
+#include "contour_store.h"
+
+class ThreadPool;
+
+// An image read strip by strip, so that it never has to be in memory whole.
+struct StripSource {
+  int height{0};
+  int width{0};
+  // Fills rgb with the RGB888 rows [first_row, first_row + row_count).
+  std::function<bool(int first_row, int row_count, cv::Mat &rgb)> read{};
+};
+
+struct TileOptions {
+  int strip_rows{512};
+  size_t thread_count{0}; // 0 means one thread per core
+  // Pool to detect on instead of one of thread_count threads made per call.
+  ThreadPool *pool{nullptr};
+};
+
+StripSource matStripSource(const cv::Mat &rgb);
+StripSource fileStripSource(const std::string &file_path);
+
+int morphologyHalo(const MorphologySettings &morphology);
+
+ContourStore
+detectTiled(const StripSource &source, const TileOptions &options,
+            const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+            const MorphologySettings &morphology);
+ContourStore getContourVectorTiled(const StripSource &source,
+                                   const TileOptions &options);
+ContourStore getContourVectorBanded(const cv::Mat &rgb,
+                                    size_t thread_count = 0);
+
+#endif // TILED_DETECTION_H_
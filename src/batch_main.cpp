@@ -0,0 +1,90 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+#include "batch_processor.h"
+
+namespace {
+void printUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [-j THREADS] [-o OUTPUT_DIR] [--max-height PIXELS]"
+               " [--tile-rows ROWS] [--cache CACHE_DIR] [--archive FILE]"
+               " <image or directory>...\n";
+}
+
+void printStage(const char *name, double seconds, size_t images) {
+  std::cout << "  " << std::left << std::setw(8) << name << std::right
+            << std::setw(10) << seconds << " s total, " << std::setw(8)
+            << (images == 0 ? 0.0 : seconds * 1000.0 / images)
+            << " ms/image\n";
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  BatchOptions options{};
+  std::vector<std::string> inputs{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if ((arg == "-j" || arg == "-o" || arg == "--max-height" ||
+         arg == "--tile-rows" || arg == "--cache" || arg == "--archive") &&
+        i + 1 < argc) {
+      std::string value{argv[++i]};
+      if (arg == "-j") {
+        options.thread_count = std::strtoul(value.c_str(), nullptr, 10);
+      } else if (arg == "-o") {
+        options.output_dir = value;
+      } else if (arg == "--tile-rows") {
+        options.tile_rows = std::atoi(value.c_str());
+      } else if (arg == "--cache") {
+        options.cache_dir = value;
+      } else if (arg == "--archive") {
+        options.archive_path = value;
+      } else {
+        options.max_height = std::atoi(value.c_str());
+      }
+    } else if (arg == "-h" || arg == "--help") {
+      printUsage(argv[0]);
+      return 0;
+    } else if (!arg.empty() && arg[0] == '-') {
+      printUsage(argv[0]);
+      return 1;
+    } else {
+      inputs.push_back(arg);
+    }
+  }
+
+  std::vector<BatchImage> batch_images{collectImagePaths(inputs)};
+  if (batch_images.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  BatchReport report{runBatch(batch_images, options)};
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "Processed " << report.images_processed << " images ("
+            << report.images_failed << " failed), "
+            << report.contours_found << " contours in " << report.wall_seconds
+            << " s: "
+            << (report.wall_seconds > 0.0
+                    ? report.images_processed / report.wall_seconds
+                    : 0.0)
+            << " images/s\n";
+  if (!options.cache_dir.empty()) {
+    std::cout << "Cache hits: " << report.cache_hits << "\n";
+  }
+  if (!options.archive_path.empty() && !report.archive_written) {
+    std::cerr << "Cannot write archive " << options.archive_path << "\n";
+  }
+  std::cout << "Stage timings (summed over threads):\n";
+  size_t images{report.images_processed + report.images_failed};
+  printStage("decode", report.decode_seconds, images);
+  printStage("detect", report.detect_seconds, images);
+  printStage("write", report.write_seconds, images);
+
+  return report.images_failed == 0 &&
+                 (options.archive_path.empty() || report.archive_written)
+             ? 0
+             : 2;
+}
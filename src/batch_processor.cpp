@@ -0,0 +1,281 @@
+#include "batch_processor.h"
+#include "contour_archive.h"
+#include "contour_cache.h"
+#include "contour_detection.h"
+#include "image_hash.h"
+#include "thread_pool.h"
+#include "tiled_detection.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+bool isSupportedImage(const std::filesystem::path &path) {
+  std::string extension{path.extension().string()};
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+
+  return extension == ".png" || extension == ".jpg" || extension == ".jpeg";
+}
+
+int64_t elapsedNs(Clock::time_point since) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              since)
+      .count();
+}
+} // namespace
+
+/**
+ * @brief Expands the command line inputs into a list of image files.
+ *        Directories are searched recursively for png and jpg images, whose
+ *        results mirror their path relative to the directory given; the
+ *        results of images given as files go to the top of the output
+ *        directory.
+ *
+ * @param inputs Image files and directories.
+ * @return Images sorted by path, with the names of their result files.
+ */
+std::vector<BatchImage>
+collectImagePaths(const std::vector<std::string> &inputs) {
+  std::vector<BatchImage> images{};
+  for (const std::string &input : inputs) {
+    std::error_code error{};
+    if (std::filesystem::is_directory(input, error)) {
+      for (const auto &entry :
+           std::filesystem::recursive_directory_iterator(input, error)) {
+        if (entry.is_regular_file() && isSupportedImage(entry.path())) {
+          images.push_back(
+              {entry.path().string(),
+               entry.path().lexically_relative(input).string() + ".contours"});
+        }
+      }
+    } else if (std::filesystem::is_regular_file(input, error)) {
+      images.push_back(
+          {input,
+           std::filesystem::path(input).filename().string() + ".contours"});
+    }
+  }
+  std::sort(images.begin(), images.end(),
+            [](const BatchImage &a, const BatchImage &b) {
+              return a.path < b.path;
+            });
+
+  return images;
+}
+
+/**
+ * @brief Decodes every image and detects its contours on a thread pool,
+ *        writing one result file per image into the output directory.
+ *        Images whose result file another image already takes, such as the
+ *        same name given from two directories, fail rather than overwrite it.
+ *
+ * @param images Images to process;
+ * @param options Output directory, thread count and detection scale.
+ * @return Counters and per-stage timings of the run.
+ */
+BatchReport runBatch(const std::vector<BatchImage> &images,
+                     const BatchOptions &options) {
+  std::filesystem::create_directories(options.output_dir);
+
+  std::atomic<size_t> processed{0};
+  std::atomic<size_t> failed{0};
+  std::atomic<size_t> contours_found{0};
+  std::atomic<size_t> cache_hits{0};
+  std::atomic<int64_t> decode_ns{0};
+  std::atomic<int64_t> detect_ns{0};
+  std::atomic<int64_t> write_ns{0};
+
+  std::unique_ptr<ContourCache> cache{};
+  if (!options.cache_dir.empty()) {
+    cache = std::make_unique<ContourCache>(options.cache_dir);
+  }
+
+  // Every image's contours go into the archive as well, as they are done.
+  ContourArchiveWriter archive{};
+  std::mutex archive_mutex{};
+
+  // Tiled detection spreads the strips of one image over the threads, so
+  // images are taken one at a time.
+  bool tiled{options.tile_rows > 0 && options.max_height == 0};
+
+  Clock::time_point batch_start{Clock::now()};
+  {
+    size_t thread_count{options.thread_count == 0
+                            ? std::thread::hardware_concurrency()
+                            : options.thread_count};
+    ThreadPool pool{tiled ? 1 : thread_count};
+    std::set<std::filesystem::path> output_paths{};
+    for (const BatchImage &image : images) {
+      std::filesystem::path output_path{
+          (std::filesystem::path(options.output_dir) / image.output_name)
+              .lexically_normal()};
+      if (!output_paths.insert(output_path).second) {
+        ++failed;
+        continue;
+      }
+      const std::string &image_path{image.path};
+      pool.submit([&, image_path, output_path]() {
+        try {
+          Clock::time_point stage_start{Clock::now()};
+          ContourStore contours{};
+          int img_height{0};
+          int img_width{0};
+          if (tiled) {
+            // The file is read strip by strip inside detection, so decoding
+            // counts as detection time.
+            StripSource source{fileStripSource(image_path)};
+            if (source.height == 0) {
+              ++failed;
+              return;
+            }
+            img_height = source.height;
+            img_width = source.width;
+            std::string cache_key{};
+            if (cache != nullptr) {
+              cache_key = ContourCache::makeKey(
+                  hashImageFile(image_path),
+                  contourDetectorParameters() + ";decoder=qt", source.height,
+                  source.width);
+            }
+            if (cache != nullptr && cache->get(cache_key, contours)) {
+              ++cache_hits;
+            } else {
+              contours = getContourVectorTiled(
+                  source, TileOptions{options.tile_rows, options.thread_count});
+              if (cache != nullptr) {
+                cache->put(cache_key, contours);
+              }
+            }
+            detect_ns += elapsedNs(stage_start);
+          } else {
+            // Read once, for both decoding and the cache key.
+            std::ifstream file{image_path, std::ios::binary};
+            std::vector<uchar> data{std::istreambuf_iterator<char>(file),
+                                    std::istreambuf_iterator<char>()};
+            cv::Mat img{};
+            if (!data.empty()) {
+              img = cv::imdecode(data, cv::IMREAD_COLOR);
+            }
+            if (img.empty()) {
+              ++failed;
+              return;
+            }
+            // Same size limit as the one the GUI applies when opening images,
+            // though not the same scaler: Qt's scaled() there, area
+            // interpolation here. The cache key names the scaler, so neither
+            // is served the other's contours.
+            if (options.max_height > 0 && img.rows > options.max_height) {
+              cv::resize(img, img,
+                         cv::Size(img.cols * options.max_height / img.rows,
+                                  options.max_height),
+                         0, 0, cv::INTER_AREA);
+            }
+            // getContourVector expects RGB, as wrapQImageAsCvMat gives it.
+            cv::cvtColor(img, img, cv::COLOR_BGR2RGB);
+            img_height = img.rows;
+            img_width = img.cols;
+            decode_ns += elapsedNs(stage_start);
+
+            stage_start = Clock::now();
+            std::string cache_key{};
+            if (cache != nullptr) {
+              cache_key = ContourCache::makeKey(
+                  hashImageData(QByteArray::fromRawData(
+                      reinterpret_cast<const char *>(data.data()),
+                      static_cast<int>(data.size()))),
+                  contourDetectorParameters() + ";scaler=cv-area", img.rows,
+                  img.cols);
+            }
+            if (cache != nullptr && cache->get(cache_key, contours)) {
+              ++cache_hits;
+            } else {
+              // Each pool thread keeps its detection buffers from image to
+              // image.
+              thread_local DetectionScratch scratch{};
+              getContourVector(img, scratch, contours);
+              if (cache != nullptr) {
+                cache->put(cache_key, contours);
+              }
+            }
+            detect_ns += elapsedNs(stage_start);
+          }
+
+          stage_start = Clock::now();
+          std::error_code error{};
+          std::filesystem::create_directories(output_path.parent_path(),
+                                              error);
+          bool written{writeContoursFile(output_path.string(), contours)};
+          if (written && !options.archive_path.empty()) {
+            std::lock_guard<std::mutex> lock{archive_mutex};
+            archive.add(image_path, img_height, img_width, contours);
+          }
+          write_ns += elapsedNs(stage_start);
+
+          if (written) {
+            ++processed;
+            contours_found += contours.size();
+          } else {
+            ++failed;
+          }
+        } catch (...) {
+          ++failed;
+        }
+      });
+    }
+    pool.wait();
+  }
+
+  BatchReport report{};
+  if (!options.archive_path.empty()) {
+    Clock::time_point stage_start{Clock::now()};
+    report.archive_written = archive.write(options.archive_path);
+    write_ns += elapsedNs(stage_start);
+  }
+
+  report.images_processed = processed;
+  report.images_failed = failed;
+  report.contours_found = contours_found;
+  report.cache_hits = cache_hits;
+  report.wall_seconds =
+      std::chrono::duration<double>(Clock::now() - batch_start).count();
+  report.decode_seconds = decode_ns * 1e-9;
+  report.detect_seconds = detect_ns * 1e-9;
+  report.write_seconds = write_ns * 1e-9;
+
+  return report;
+}
+
+/**
+ * @brief Writes contours as plain text, one contour per line:
+ *        contour number, point count, then x and y of every point.
+ *
+ * @param file_path Output file;
+ * @param contours Contours to write.
+ * @return Whether the file has been written successfully.
+ */
+bool writeContoursFile(const std::string &file_path,
+                       const ContourStore &contours) {
+  std::ofstream file{file_path};
+  if (!file) {
+    return false;
+  }
+
+  for (size_t i = 0; i != contours.size(); ++i) {
+    file << i << ' ' << contours[i].size;
+    for (const cv::Point &point : contours[i]) {
+      file << ' ' << point.x << ' ' << point.y;
+    }
+    file << '\n';
+  }
+
+  return static_cast<bool>(file);
+}
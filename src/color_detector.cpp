@@ -0,0 +1,183 @@
+#include "color_detector.h"
+
+#include <stdexcept>
+
+/**
+ * @brief Opening followed by closing of a binary mask.
+ *
+ * @param mask Mask to process in place;
+ * @param morphology Kernel sizes, 0 skips a step.
+ */
+void applyMorphology(cv::Mat &mask, const MorphologySettings &morphology) {
+  cv::Mat buffer{};
+  applyMorphology(mask, morphology, buffer);
+}
+
+/**
+ * @brief Same as applyMorphology, with the intermediate image kept in buffer
+ *        rather than allocated. Erosion and dilation alternate between mask
+ *        and buffer, as cv::morphologyEx does with a temporary of its own.
+ *
+ * @param mask Mask to process in place;
+ * @param morphology Kernel sizes, 0 skips a step;
+ * @param buffer Intermediate image, reused if it has the size of mask.
+ */
+void applyMorphology(cv::Mat &mask, const MorphologySettings &morphology,
+                     cv::Mat &buffer) {
+  PROFILE_SCOPE("morphology");
+  // Image erosion followed by dilation.
+  // Used to remove contours with tiny area from the image.
+  if (morphology.open_size > 0) {
+    cv::Mat kernel{cv::getStructuringElement(
+        cv::MORPH_ELLIPSE,
+        cv::Size(morphology.open_size, morphology.open_size))};
+    cv::erode(mask, buffer, kernel);
+    cv::dilate(buffer, mask, kernel);
+  }
+  // Image dilation followed by erosion.
+  // Used to fuse together nearby contours.
+  if (morphology.close_size > 0) {
+    cv::Mat kernel{cv::getStructuringElement(
+        cv::MORPH_ELLIPSE,
+        cv::Size(morphology.close_size, morphology.close_size))};
+    cv::dilate(mask, buffer, kernel);
+    cv::erode(buffer, mask, kernel);
+  }
+}
+
+/**
+ * @brief Traces the outer contours of a mask into a store, computing their
+ *        features on the way.
+ */
+ContourStore findExternalContours(const cv::Mat &mask) {
+  DetectionScratch scratch{};
+  ContourStore contours{};
+  findExternalContours(mask, scratch, contours);
+
+  return contours;
+}
+
+/**
+ * @brief Same as findExternalContours, tracing into the buffers of a previous
+ *        detection: cv::findContours refills the point vectors of scratch in
+ *        place, and the store keeps its capacity.
+ */
+void findExternalContours(const cv::Mat &mask, DetectionScratch &scratch,
+                          ContourStore &contours) {
+  PROFILE_SCOPE("find contours");
+  // cv::RETR_EXTERNAL mode is used to prevent having contours inside other
+  // contours.
+  cv::findContours(mask, scratch.contours, cv::RETR_EXTERNAL,
+                   cv::CHAIN_APPROX_SIMPLE);
+  contours.assign(scratch.contours);
+}
+
+ColorRangeDetector::ColorRangeDetector(std::vector<ColorClass> color_classes,
+                                       MorphologySettings morphology)
+    : m_color_classes{std::move(color_classes)}, m_morphology{morphology} {
+  if (m_color_classes.size() > kMaxClasses) {
+    throw std::invalid_argument("ColorRangeDetector: too many color classes");
+  }
+
+  size_t range_index{0};
+  for (const ColorClass &color_class : m_color_classes) {
+    uint32_t class_ranges{0};
+    for (const HsvRange &range : color_class.ranges) {
+      if (range_index == kMaxRanges) {
+        throw std::invalid_argument("ColorRangeDetector: too many ranges");
+      }
+
+      uint32_t bit{1u << range_index++};
+      class_ranges |= bit;
+      for (int i = 0; i != 256; ++i) {
+        if (i >= range.hue_min && i <= range.hue_max) {
+          m_hue_lut[i] |= bit;
+        }
+        if (i >= range.saturation_min && i <= range.saturation_max) {
+          m_saturation_lut[i] |= bit;
+        }
+        if (i >= range.value_min && i <= range.value_max) {
+          m_value_lut[i] |= bit;
+        }
+      }
+    }
+    m_class_ranges.push_back(class_ranges);
+  }
+}
+
+/**
+ * @brief Same as the overload below, with the HSV image in a buffer of its
+ *        own.
+ */
+void ColorRangeDetector::computeLabelMask(const cv::Mat &rgb,
+                                          cv::Mat &labels) const {
+  cv::Mat hsv_image{};
+  computeLabelMask(rgb, labels, hsv_image);
+}
+
+/**
+ * @brief Classifies every pixel against all color classes in one pass.
+ *        The image is converted to HSV in one call, which lets OpenCV
+ *        vectorize and parallelize the conversion.
+ *
+ * @param rgb 8-bit RGB image;
+ * @param labels Receives an 8-bit image where bit i is set for the pixels of
+ *        color class i;
+ * @param hsv_image Buffer for the HSV image, reused if large enough.
+ */
+void ColorRangeDetector::computeLabelMask(const cv::Mat &rgb, cv::Mat &labels,
+                                          cv::Mat &hsv_image) const {
+  PROFILE_SCOPE("color mask");
+  CV_Assert(rgb.type() == CV_8UC3);
+  labels.create(rgb.rows, rgb.cols, CV_8UC1);
+
+  cv::cvtColor(rgb, hsv_image, cv::COLOR_RGB2HSV);
+  for (int y = 0; y != rgb.rows; ++y) {
+    const uchar *hsv{hsv_image.ptr<uchar>(y)};
+    uchar *dst{labels.ptr<uchar>(y)};
+    for (int x = 0; x != rgb.cols; ++x) {
+      uint32_t ranges{m_hue_lut[hsv[3 * x]] & m_saturation_lut[hsv[3 * x + 1]] &
+                      m_value_lut[hsv[3 * x + 2]]};
+      uchar label{0};
+      if (ranges != 0) {
+        for (size_t i = 0; i != m_class_ranges.size(); ++i) {
+          if (ranges & m_class_ranges[i]) {
+            label |= static_cast<uchar>(1u << i);
+          }
+        }
+      }
+      dst[x] = label;
+    }
+  }
+}
+
+/**
+ * @brief Detects the contours of every color class.
+ *
+ * @param rgb 8-bit RGB image.
+ * @return Per color class, in the order they were given, the contours.
+ */
+std::vector<ContourStore> ColorRangeDetector::detect(const cv::Mat &rgb) const {
+  // The classes share one set of buffers.
+  DetectionScratch scratch{};
+  cv::Mat labels{};
+  computeLabelMask(rgb, labels, scratch.hsv);
+  scratch.hsv.release();
+
+  std::vector<ContourStore> contours(m_color_classes.size());
+  scratch.mask.create(labels.rows, labels.cols, CV_8UC1);
+  for (size_t i = 0; i != m_color_classes.size(); ++i) {
+    uchar bit{static_cast<uchar>(1u << i)};
+    for (int y = 0; y != labels.rows; ++y) {
+      const uchar *src{labels.ptr<uchar>(y)};
+      uchar *dst{scratch.mask.ptr<uchar>(y)};
+      for (int x = 0; x != labels.cols; ++x) {
+        dst[x] = (src[x] & bit) ? 255 : 0;
+      }
+    }
+    applyMorphology(scratch.mask, m_morphology, scratch.morphology);
+    findExternalContours(scratch.mask, scratch, contours[i]);
+  }
+
+  return contours;
+}
@@ -0,0 +1,242 @@
+#include "color_mask.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define CONTOURS_SIMD_SSE2
+#endif
+
+// The red mask used to be computed as
+//   cvtColor(RGB2HSV) -> inRange({0, 90, 90}, {4, 255, 255})
+//                      + inRange({176, 90, 90}, {180, 255, 255}).
+// OpenCV computes 8-bit HSV with fixed point division tables:
+//   s = (diff * sdiv[v] + 2048) >> 12,
+//   h = ((g - b) * hdiv[diff] + 2048) >> 12, plus 180 if negative, if v == r,
+// and if v != r the hue falls into [30, 150], which is never red.
+// Solving the thresholds against the tables gives an equivalent test that
+// needs neither the HSV image nor the tables:
+//   v == r and v >= 90,
+//   s >= 90 <=> 208 * diff >= 73 * v,
+//   h <= 4 or h >= 176 <=> 20 * |g - b| < 3 * diff, except when both sides are
+//   equal and table rounding decides: then it is red for g > b only if
+//   diff == 200, and for g < b unless diff is 100, 140, 180 or 220.
+// The equivalence has been checked against OpenCV for all 2^24 RGB values.
+namespace {
+constexpr int kMinSaturationValue{90};
+
+inline bool isRedPixel(int r, int g, int b) {
+  int v{std::max(r, std::max(g, b))};
+  if (v != r || v < kMinSaturationValue) {
+    return false;
+  }
+
+  int diff{v - std::min(g, b)};
+  if (208 * diff < 73 * v) {
+    return false;
+  }
+
+  int hue_lhs{20 * std::abs(g - b)};
+  int hue_rhs{3 * diff};
+  if (hue_lhs != hue_rhs) {
+    return hue_lhs < hue_rhs;
+  }
+  if (g > b) {
+    return diff == 200;
+  }
+  return diff != 100 && diff != 140 && diff != 180 && diff != 220;
+}
+
+#ifdef CONTOURS_SIMD_SSE2
+// Splits 16 interleaved RGB pixels into channel planes using SSE2 only.
+inline void deinterleave16(const uchar *rgb, __m128i &c0, __m128i &c1,
+                           __m128i &c2) {
+  __m128i t00{_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb))};
+  __m128i t01{_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 16))};
+  __m128i t02{_mm_loadu_si128(reinterpret_cast<const __m128i *>(rgb + 32))};
+
+  __m128i t10{_mm_unpacklo_epi8(t00, _mm_unpackhi_epi64(t01, t01))};
+  __m128i t11{_mm_unpacklo_epi8(_mm_unpackhi_epi64(t00, t00), t02)};
+  __m128i t12{_mm_unpacklo_epi8(t01, _mm_unpackhi_epi64(t02, t02))};
+
+  __m128i t20{_mm_unpacklo_epi8(t10, _mm_unpackhi_epi64(t11, t11))};
+  __m128i t21{_mm_unpacklo_epi8(_mm_unpackhi_epi64(t10, t10), t12)};
+  __m128i t22{_mm_unpacklo_epi8(t11, _mm_unpackhi_epi64(t12, t12))};
+
+  __m128i t30{_mm_unpacklo_epi8(t20, _mm_unpackhi_epi64(t21, t21))};
+  __m128i t31{_mm_unpacklo_epi8(_mm_unpackhi_epi64(t20, t20), t22)};
+  __m128i t32{_mm_unpacklo_epi8(t21, _mm_unpackhi_epi64(t22, t22))};
+
+  c0 = _mm_unpacklo_epi8(t30, _mm_unpackhi_epi64(t31, t31));
+  c1 = _mm_unpacklo_epi8(_mm_unpackhi_epi64(t30, t30), t32);
+  c2 = _mm_unpacklo_epi8(t31, _mm_unpackhi_epi64(t32, t32));
+}
+
+struct Sse2 {
+  using Vec = __m128i;
+  static constexpr int kPixels{16};
+
+  static void load(const uchar *rgb, Vec &r, Vec &g, Vec &b) {
+    deinterleave16(rgb, r, g, b);
+  }
+  static void store(uchar *dst, Vec v) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+  }
+  static Vec set8(int x) { return _mm_set1_epi8(static_cast<char>(x)); }
+  static Vec set16(int x) { return _mm_set1_epi16(static_cast<short>(x)); }
+  static Vec zero() { return _mm_setzero_si128(); }
+  static Vec and_(Vec a, Vec b) { return _mm_and_si128(a, b); }
+  static Vec andnot(Vec a, Vec b) { return _mm_andnot_si128(a, b); }
+  static Vec or_(Vec a, Vec b) { return _mm_or_si128(a, b); }
+  static Vec maxu8(Vec a, Vec b) { return _mm_max_epu8(a, b); }
+  static Vec minu8(Vec a, Vec b) { return _mm_min_epu8(a, b); }
+  static Vec sub8(Vec a, Vec b) { return _mm_sub_epi8(a, b); }
+  static Vec subsu8(Vec a, Vec b) { return _mm_subs_epu8(a, b); }
+  static Vec eq8(Vec a, Vec b) { return _mm_cmpeq_epi8(a, b); }
+  static Vec lo16(Vec a) { return _mm_unpacklo_epi8(a, zero()); }
+  static Vec hi16(Vec a) { return _mm_unpackhi_epi8(a, zero()); }
+  static Vec mul16(Vec a, Vec b) { return _mm_mullo_epi16(a, b); }
+  static Vec subsu16(Vec a, Vec b) { return _mm_subs_epu16(a, b); }
+  static Vec eq16(Vec a, Vec b) { return _mm_cmpeq_epi16(a, b); }
+  static Vec lt16(Vec a, Vec b) { return _mm_cmplt_epi16(a, b); }
+  static Vec pack16(Vec lo, Vec hi) { return _mm_packs_epi16(lo, hi); }
+};
+
+#ifdef __AVX2__
+struct Avx2 {
+  using Vec = __m256i;
+  static constexpr int kPixels{32};
+
+  static void load(const uchar *rgb, Vec &r, Vec &g, Vec &b) {
+    __m128i r0, g0, b0, r1, g1, b1;
+    deinterleave16(rgb, r0, g0, b0);
+    deinterleave16(rgb + 48, r1, g1, b1);
+    r = _mm256_inserti128_si256(_mm256_castsi128_si256(r0), r1, 1);
+    g = _mm256_inserti128_si256(_mm256_castsi128_si256(g0), g1, 1);
+    b = _mm256_inserti128_si256(_mm256_castsi128_si256(b0), b1, 1);
+  }
+  static void store(uchar *dst, Vec v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), v);
+  }
+  static Vec set8(int x) { return _mm256_set1_epi8(static_cast<char>(x)); }
+  static Vec set16(int x) { return _mm256_set1_epi16(static_cast<short>(x)); }
+  static Vec zero() { return _mm256_setzero_si256(); }
+  static Vec and_(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+  static Vec andnot(Vec a, Vec b) { return _mm256_andnot_si256(a, b); }
+  static Vec or_(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+  static Vec maxu8(Vec a, Vec b) { return _mm256_max_epu8(a, b); }
+  static Vec minu8(Vec a, Vec b) { return _mm256_min_epu8(a, b); }
+  static Vec sub8(Vec a, Vec b) { return _mm256_sub_epi8(a, b); }
+  static Vec subsu8(Vec a, Vec b) { return _mm256_subs_epu8(a, b); }
+  static Vec eq8(Vec a, Vec b) { return _mm256_cmpeq_epi8(a, b); }
+  // Unpacking and packing both work per 128-bit lane, so the pixel order
+  // survives the round trip through 16-bit lanes.
+  static Vec lo16(Vec a) { return _mm256_unpacklo_epi8(a, zero()); }
+  static Vec hi16(Vec a) { return _mm256_unpackhi_epi8(a, zero()); }
+  static Vec mul16(Vec a, Vec b) { return _mm256_mullo_epi16(a, b); }
+  static Vec subsu16(Vec a, Vec b) { return _mm256_subs_epu16(a, b); }
+  static Vec eq16(Vec a, Vec b) { return _mm256_cmpeq_epi16(a, b); }
+  static Vec lt16(Vec a, Vec b) { return _mm256_cmpgt_epi16(b, a); }
+  static Vec pack16(Vec lo, Vec hi) { return _mm256_packs_epi16(lo, hi); }
+};
+#endif
+
+// Returns 0xFFFF in 16-bit lanes where the saturation check passes and
+// where the hue check passes strictly / is decided by rounding.
+template <typename Ops>
+inline void wideChecks(typename Ops::Vec v, typename Ops::Vec diff,
+                       typename Ops::Vec abs_h, typename Ops::Vec &sat_ok,
+                       typename Ops::Vec &hue_lt, typename Ops::Vec &hue_eq) {
+  using Vec = typename Ops::Vec;
+  Vec v16[2]{Ops::lo16(v), Ops::hi16(v)};
+  Vec diff16[2]{Ops::lo16(diff), Ops::hi16(diff)};
+  Vec h16[2]{Ops::lo16(abs_h), Ops::hi16(abs_h)};
+
+  Vec sat[2], lt[2], eq[2];
+  for (int i = 0; i != 2; ++i) {
+    // Products reach 53040, so the comparison is done unsigned.
+    sat[i] = Ops::eq16(Ops::subsu16(Ops::mul16(v16[i], Ops::set16(73)),
+                                    Ops::mul16(diff16[i], Ops::set16(208))),
+                       Ops::zero());
+    Vec lhs{Ops::mul16(h16[i], Ops::set16(20))};
+    Vec rhs{Ops::mul16(diff16[i], Ops::set16(3))};
+    lt[i] = Ops::lt16(lhs, rhs);
+    eq[i] = Ops::eq16(lhs, rhs);
+  }
+  sat_ok = Ops::pack16(sat[0], sat[1]);
+  hue_lt = Ops::pack16(lt[0], lt[1]);
+  hue_eq = Ops::pack16(eq[0], eq[1]);
+}
+
+template <typename Ops>
+int redMaskRowSimd(const uchar *rgb, uchar *mask, int width) {
+  using Vec = typename Ops::Vec;
+  int x{0};
+  for (; x + Ops::kPixels <= width; x += Ops::kPixels) {
+    Vec r, g, b;
+    Ops::load(rgb + 3 * x, r, g, b);
+
+    Vec v{Ops::maxu8(r, Ops::maxu8(g, b))};
+    Vec r_is_max{Ops::eq8(r, v)};
+    Vec v_ok{Ops::eq8(Ops::maxu8(v, Ops::set8(kMinSaturationValue)), v)};
+    // Where r is the maximum, min(r, g, b) == min(g, b).
+    Vec diff{Ops::sub8(v, Ops::minu8(g, b))};
+    Vec g_minus_b{Ops::subsu8(g, b)};
+    Vec abs_h{Ops::or_(g_minus_b, Ops::subsu8(b, g))};
+    Vec g_le_b{Ops::eq8(g_minus_b, Ops::zero())};
+
+    Vec sat_ok, hue_lt, hue_eq;
+    wideChecks<Ops>(v, diff, abs_h, sat_ok, hue_lt, hue_eq);
+
+    Vec rounding_exception{
+        Ops::or_(Ops::or_(Ops::eq8(diff, Ops::set8(100)),
+                          Ops::eq8(diff, Ops::set8(140))),
+                 Ops::or_(Ops::eq8(diff, Ops::set8(180)),
+                          Ops::eq8(diff, Ops::set8(220))))};
+    Vec tie_is_red{Ops::or_(
+        Ops::andnot(g_le_b, Ops::eq8(diff, Ops::set8(200))),
+        Ops::andnot(rounding_exception, g_le_b))};
+    Vec hue_ok{Ops::or_(hue_lt, Ops::and_(hue_eq, tie_is_red))};
+
+    Ops::store(mask + x, Ops::and_(Ops::and_(r_is_max, v_ok),
+                                   Ops::and_(sat_ok, hue_ok)));
+  }
+
+  return x;
+}
+#endif
+
+void redMaskRow(const uchar *rgb, uchar *mask, int width) {
+  int x{0};
+#if defined(__AVX2__)
+  x = redMaskRowSimd<Avx2>(rgb, mask, width);
+#elif defined(CONTOURS_SIMD_SSE2)
+  x = redMaskRowSimd<Sse2>(rgb, mask, width);
+#endif
+  for (; x < width; ++x) {
+    const uchar *pixel{rgb + 3 * x};
+    mask[x] = isRedPixel(pixel[0], pixel[1], pixel[2]) ? 255 : 0;
+  }
+}
+} // namespace
+
+/**
+ * @brief Computes the binary mask of red pixels straight from an RGB image,
+ *        in a single pass and without allocating the HSV image. The result
+ *        is identical to the one of the cvtColor and inRange based pipeline.
+ *
+ * @param rgb 8-bit 3-channel RGB image;
+ * @param mask Receives the 8-bit mask, 255 for red pixels and 0 otherwise.
+ */
+void computeRedMask(const cv::Mat &rgb, cv::Mat &mask) {
+  CV_Assert(rgb.type() == CV_8UC3);
+  mask.create(rgb.rows, rgb.cols, CV_8UC1);
+
+  int rows{rgb.rows};
+  int cols{rgb.cols};
+  if (rgb.isContinuous() && mask.isContinuous()) {
+    cols *= rows;
+    rows = 1;
+  }
+  for (int y = 0; y != rows; ++y) {
+    redMaskRow(rgb.ptr<uchar>(y), mask.ptr<uchar>(y), cols);
+  }
+}
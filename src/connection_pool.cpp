@@ -0,0 +1,101 @@
+#include "connection_pool.h"
+#include "sql_query_handler.h"
+
+/**
+ * @brief Pool of database connections. Connections are opened on first use,
+ *        up to max_size of them, and reused afterwards.
+ *
+ * @param conn_string libpq connection string;
+ * @param max_size Maximum number of open connections.
+ */
+ConnectionPool::ConnectionPool(std::string conn_string, size_t max_size)
+    : m_conn_string{std::move(conn_string)},
+      m_max_size{max_size == 0 ? 1 : max_size} {}
+
+ConnectionPool::~ConnectionPool() {
+  if (m_background_connect.joinable()) {
+    m_background_connect.join();
+  }
+}
+
+ConnectionPool::Lease::~Lease() {
+  if (m_pool != nullptr && m_conn != nullptr) {
+    m_pool->release(std::move(m_conn));
+  }
+}
+
+/**
+ * @brief Takes an idle connection, opens a new one if the pool is not full or
+ *        waits for one to be released.
+ *
+ * @return Lease of the connection.
+ * @throws pqxx::broken_connection if a new connection cannot be opened.
+ */
+ConnectionPool::Lease ConnectionPool::acquire() {
+  {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_released.wait(lock,
+                    [this] { return !m_idle.empty() || m_open < m_max_size; });
+    if (!m_idle.empty()) {
+      std::unique_ptr<pqxx::connection> conn{std::move(m_idle.back())};
+      m_idle.pop_back();
+      return Lease{*this, std::move(conn)};
+    }
+    ++m_open;
+  }
+
+  // Connecting takes a round trip or more, other callers are not held up.
+  try {
+    return Lease{*this, connect()};
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock{m_mutex};
+      --m_open;
+    }
+    m_released.notify_one();
+    throw;
+  }
+}
+
+/**
+ * @brief Opens the first connection on a background thread, so that it is
+ *        usually ready by the time it is needed without blocking the caller.
+ *        Failures are ignored; acquire() retries.
+ */
+void ConnectionPool::connectInBackground() {
+  if (m_background_connect.joinable()) {
+    return;
+  }
+
+  m_background_connect = std::thread{[this] {
+    try {
+      Lease lease{acquire()};
+    } catch (...) {
+    }
+  }};
+}
+
+std::unique_ptr<pqxx::connection> ConnectionPool::connect() {
+  std::unique_ptr<pqxx::connection> conn{
+      std::make_unique<pqxx::connection>(m_conn_string)};
+  // Prepared statements belong to a connection.
+  prepareStatements(*conn);
+
+  return conn;
+}
+
+/**
+ * @brief Gives a connection back. Broken connections are dropped, so that the
+ *        next acquire() opens a fresh one.
+ */
+void ConnectionPool::release(std::unique_ptr<pqxx::connection> conn) {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (conn->is_open()) {
+      m_idle.push_back(std::move(conn));
+    } else {
+      --m_open;
+    }
+  }
+  m_released.notify_one();
+}
@@ -0,0 +1,270 @@
+#include "contour_archive.h"
+#include "contour_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
+namespace {
+constexpr ArchiveHeader kHeader{};
+
+uint64_t alignTo8(uint64_t offset) { return (offset + 7) & ~uint64_t{7}; }
+
+template <typename T>
+void writeRecords(std::ofstream &file, const T *records, size_t count) {
+  file.write(reinterpret_cast<const char *>(records),
+             static_cast<std::streamsize>(count * sizeof(T)));
+}
+} // namespace
+
+/**
+ * @brief Adds the contours of an image, encoding their points.
+ *
+ * @param name Image's name, e.g. its file path;
+ * @param img_height Height of the image detection ran on;
+ * @param img_width Width of the image detection ran on;
+ * @param contours Image's contours.
+ */
+void ContourArchiveWriter::add(const std::string &name, int img_height,
+                               int img_width, const ContourStore &contours) {
+  Image image{name, img_height, img_width, {}, {}};
+  image.contours.reserve(contours.size());
+  for (size_t i = 0; i != contours.size(); ++i) {
+    const cv::Rect &bbox{contours.bbox(i)};
+    ArchiveContour record{};
+    record.points_offset = image.points.size();
+    record.point_count = static_cast<uint32_t>(contours[i].size);
+    record.x = bbox.x;
+    record.y = bbox.y;
+    record.width = bbox.width;
+    record.height = bbox.height;
+    record.area = contours.area(i);
+    record.perimeter = contours.perimeter(i);
+
+    cv::Point previous{bbox.tl()};
+    for (const cv::Point &point : contours[i]) {
+      writeVarint(image.points, zigzagEncode(point.x - previous.x));
+      writeVarint(image.points, zigzagEncode(point.y - previous.y));
+      previous = point;
+    }
+    record.points_size =
+        static_cast<uint32_t>(image.points.size() - record.points_offset);
+    image.contours.push_back(record);
+  }
+  m_images.push_back(std::move(image));
+}
+
+/**
+ * @brief Writes the images added so far, sorted by name, so that the same
+ *        images give the same file whatever order they were added in.
+ *
+ * @param file_path Output file.
+ * @return Whether the file has been written successfully.
+ */
+bool ContourArchiveWriter::write(const std::string &file_path) const {
+  std::vector<size_t> order(m_images.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+    return m_images[a].name < m_images[b].name;
+  });
+
+  ArchiveHeader header{};
+  std::vector<ArchiveImage> images{};
+  images.reserve(m_images.size());
+  for (size_t index : order) {
+    const Image &image{m_images[index]};
+    ArchiveImage record{};
+    record.name_offset = header.names_size;
+    record.name_size = static_cast<uint32_t>(image.name.size());
+    record.height = image.height;
+    record.width = image.width;
+    record.first_contour = header.contour_count;
+    record.contour_count = image.contours.size();
+    images.push_back(record);
+
+    header.contour_count += image.contours.size();
+    header.points_size += image.points.size();
+    header.names_size += image.name.size();
+  }
+  header.image_count = images.size();
+  header.points_offset = sizeof(ArchiveHeader) +
+                         images.size() * sizeof(ArchiveImage) +
+                         header.contour_count * sizeof(ArchiveContour);
+  header.names_offset = alignTo8(header.points_offset + header.points_size);
+
+  std::ofstream file{file_path, std::ios::binary};
+  if (!file) {
+    return false;
+  }
+  writeRecords(file, &header, 1);
+  writeRecords(file, images.data(), images.size());
+  // Point run offsets become relative to all the runs rather than to the
+  // image's.
+  uint64_t points_base{0};
+  for (size_t index : order) {
+    std::vector<ArchiveContour> contours{m_images[index].contours};
+    for (ArchiveContour &contour : contours) {
+      contour.points_offset += points_base;
+    }
+    writeRecords(file, contours.data(), contours.size());
+    points_base += m_images[index].points.size();
+  }
+  for (size_t index : order) {
+    writeRecords(file, m_images[index].points.data(),
+                 m_images[index].points.size());
+  }
+  const char padding[8]{};
+  file.write(padding, static_cast<std::streamsize>(
+                          header.names_offset -
+                          (header.points_offset + header.points_size)));
+  for (size_t index : order) {
+    file.write(m_images[index].name.data(),
+               static_cast<std::streamsize>(m_images[index].name.size()));
+  }
+
+  return static_cast<bool>(file);
+}
+
+/**
+ * @brief Maps an archive file and checks that its header and tables are
+ *        within it. Point runs are checked as they are read.
+ *
+ * @param file_path Archive file.
+ * @return Whether the file is an archive this version can read.
+ */
+bool ContourArchive::open(const std::string &file_path) {
+  close();
+  m_file.setFileName(QString::fromStdString(file_path));
+  if (!m_file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+  uint64_t size{static_cast<uint64_t>(m_file.size())};
+  if (size < sizeof(ArchiveHeader) ||
+      (m_data = m_file.map(0, m_file.size())) == nullptr) {
+    close();
+    return false;
+  }
+
+  m_header = reinterpret_cast<const ArchiveHeader *>(m_data);
+  const ArchiveHeader &header{*m_header};
+  // The counts are bounded by the file size before they are multiplied, so
+  // that the products cannot overflow.
+  bool valid{
+      std::memcmp(header.magic, kHeader.magic, sizeof(header.magic)) == 0 &&
+      header.version == kHeader.version &&
+      header.image_count <= size / sizeof(ArchiveImage) &&
+      header.contour_count <= size / sizeof(ArchiveContour) &&
+      header.points_offset ==
+          sizeof(ArchiveHeader) + header.image_count * sizeof(ArchiveImage) +
+              header.contour_count * sizeof(ArchiveContour) &&
+      header.points_size <= size - std::min(size, header.points_offset) &&
+      header.names_offset >= header.points_offset + header.points_size &&
+      header.names_offset <= size &&
+      header.names_size <= size - header.names_offset};
+  if (!valid) {
+    close();
+    return false;
+  }
+
+  m_images = reinterpret_cast<const ArchiveImage *>(m_data +
+                                                    sizeof(ArchiveHeader));
+  m_contours = reinterpret_cast<const ArchiveContour *>(
+      m_data + sizeof(ArchiveHeader) +
+      header.image_count * sizeof(ArchiveImage));
+  for (size_t i = 0; i != header.image_count; ++i) {
+    const ArchiveImage &image{m_images[i]};
+    if (image.first_contour > header.contour_count ||
+        image.contour_count > header.contour_count - image.first_contour ||
+        image.name_offset > header.names_size ||
+        image.name_size > header.names_size - image.name_offset) {
+      close();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void ContourArchive::close() {
+  // Unmapped by QFile::close.
+  m_file.close();
+  m_data = nullptr;
+  m_header = nullptr;
+  m_images = nullptr;
+  m_contours = nullptr;
+}
+
+size_t ContourArchive::imageCount() const {
+  return m_header != nullptr ? m_header->image_count : 0;
+}
+
+size_t ContourArchive::contourCount() const {
+  return m_header != nullptr ? m_header->contour_count : 0;
+}
+
+std::string_view ContourArchive::imageName(size_t index) const {
+  return {reinterpret_cast<const char *>(m_data + m_header->names_offset +
+                                         m_images[index].name_offset),
+          m_images[index].name_size};
+}
+
+/**
+ * @brief Decodes the points of a contour.
+ *
+ * @param contour_index Contour's number across all images;
+ * @param points Receives the points.
+ * @return Whether the point run is intact.
+ */
+bool ContourArchive::readPoints(size_t contour_index,
+                                std::vector<cv::Point> &points) const {
+  const ArchiveContour &contour{m_contours[contour_index]};
+  if (contour.points_offset > m_header->points_size ||
+      contour.points_size > m_header->points_size - contour.points_offset ||
+      contour.point_count > contour.points_size / 2) {
+    return false;
+  }
+  const uint8_t *data{m_data + m_header->points_offset +
+                      contour.points_offset};
+  const uint8_t *end{data + contour.points_size};
+
+  points.resize(contour.point_count);
+  int64_t x{contour.x};
+  int64_t y{contour.y};
+  for (cv::Point &point : points) {
+    uint64_t dx{};
+    uint64_t dy{};
+    if (!readVarint(data, end, dx) || !readVarint(data, end, dy)) {
+      return false;
+    }
+    x += zigzagDecode(dx);
+    y += zigzagDecode(dy);
+    point = cv::Point(static_cast<int>(x), static_cast<int>(y));
+  }
+
+  return data == end;
+}
+
+/**
+ * @brief Decodes all contours of an image into a store, which computes their
+ *        features again.
+ *
+ * @param image_index Image's number in the archive;
+ * @param contours Receives the contours.
+ * @return Whether every point run of the image is intact.
+ */
+bool ContourArchive::readImage(size_t image_index,
+                               ContourStore &contours) const {
+  const ArchiveImage &image{m_images[image_index]};
+  contours.clear();
+
+  std::vector<cv::Point> points{};
+  for (uint64_t i = 0; i != image.contour_count; ++i) {
+    if (!readPoints(image.first_contour + i, points)) {
+      return false;
+    }
+    contours.append(points);
+  }
+
+  return true;
+}
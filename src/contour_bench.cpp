@@ -0,0 +1,360 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <map>
+#include <memory>
+
+#include "contour_detection.h"
+#include "contour_filter.h"
+#include "contour_tracker.h"
+#include "pyramid_detection.h"
+#include "region_detection.h"
+#include "sql_query_handler.h"
+#include "tiled_detection.h"
+
+// Benchmarks of the detection, hit-testing and database hot paths over
+// synthetic images. Image benchmarks take the image width and the number of
+// objects on it as arguments. Database benchmarks run against the database
+// in CONTOURS_BENCH_DB, a libpq connection string to a stand-in database
+// created with contoursDB.sql, and are skipped without it.
+//
+// Results can be saved for comparison with
+//   contour_bench --benchmark_out=results.json --benchmark_out_format=json
+
+namespace {
+using Contours = ContourStore;
+
+// Gray RGB image with red ellipses at reproducible places, 4:3.
+cv::Mat makeSyntheticImage(int width, int object_count) {
+  int height{width * 3 / 4};
+  cv::Mat img(height, width, CV_8UC3, cv::Scalar(128, 128, 128));
+  cv::RNG rng{12345};
+  int max_axis{std::max(5, width / 40)};
+  for (int i = 0; i != object_count; ++i) {
+    cv::Point center{rng.uniform(0, width), rng.uniform(0, height)};
+    cv::Size axes{rng.uniform(4, max_axis), rng.uniform(4, max_axis)};
+    cv::ellipse(img, center, axes, rng.uniform(0, 180), 0, 360,
+                cv::Scalar(220, 30, 30), cv::FILLED);
+  }
+
+  return img;
+}
+
+struct Fixture {
+  cv::Mat image{};
+  Contours contours{};
+  cv::Mat label_map{};
+  std::vector<cv::Point> clicks{};
+};
+
+// Images are generated once per size, not once per benchmark run.
+const Fixture &fixture(const benchmark::State &state) {
+  static std::map<std::pair<int64_t, int64_t>, Fixture> fixtures{};
+
+  std::pair<int64_t, int64_t> key{state.range(0), state.range(1)};
+  auto it{fixtures.find(key)};
+  if (it != fixtures.end()) {
+    return it->second;
+  }
+
+  Fixture fixture{};
+  fixture.image = makeSyntheticImage(static_cast<int>(key.first),
+                                     static_cast<int>(key.second));
+  fixture.contours = getContourVector(fixture.image);
+  fixture.label_map = buildContourLabelMap(
+      fixture.contours, fixture.image.rows, fixture.image.cols);
+  cv::RNG rng{54321};
+  for (int i = 0; i != 256; ++i) {
+    fixture.clicks.emplace_back(rng.uniform(0, fixture.image.cols),
+                                rng.uniform(0, fixture.image.rows));
+  }
+
+  return fixtures.emplace(key, std::move(fixture)).first->second;
+}
+
+void setPixelsProcessed(benchmark::State &state, const Fixture &fixture) {
+  state.SetItemsProcessed(state.iterations() * fixture.image.total());
+  state.counters["contours"] =
+      static_cast<double>(fixture.contours.size());
+}
+
+void imageArguments(benchmark::internal::Benchmark *benchmark) {
+  benchmark->ArgNames({"width", "objects"})
+      ->ArgsProduct({{640, 1600, 4000}, {16, 256}});
+}
+
+void BM_GetContourVector(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getContourVector(fixture.image));
+  }
+  setPixelsProcessed(state, fixture);
+}
+BENCHMARK(BM_GetContourVector)
+    ->Apply(imageArguments)
+    ->Unit(benchmark::kMillisecond);
+
+// Detection as the batch and the stream run it, in the buffers of the
+// previous image.
+void BM_GetContourVectorReused(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  DetectionScratch scratch{};
+  ContourStore contours{};
+  for (auto _ : state) {
+    getContourVector(fixture.image, scratch, contours);
+    benchmark::DoNotOptimize(contours.pointCount());
+  }
+  setPixelsProcessed(state, fixture);
+}
+BENCHMARK(BM_GetContourVectorReused)
+    ->Apply(imageArguments)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_GetContourVectorBanded(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getContourVectorBanded(fixture.image));
+  }
+  setPixelsProcessed(state, fixture);
+}
+BENCHMARK(BM_GetContourVectorBanded)
+    ->Apply(imageArguments)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_GetContourVectorPyramid(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getContourVectorPyramid(fixture.image));
+  }
+  setPixelsProcessed(state, fixture);
+}
+BENCHMARK(BM_GetContourVectorPyramid)
+    ->Apply(imageArguments)
+    ->Unit(benchmark::kMillisecond);
+
+// A 64 by 64 pixel edit in the middle of the image.
+void BM_RedetectRegion(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  cv::Rect dirty{fixture.image.cols / 2 - 32, fixture.image.rows / 2 - 32, 64,
+                 64};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        getContourVectorRegion(fixture.image, fixture.contours, dirty));
+  }
+  setPixelsProcessed(state, fixture);
+}
+BENCHMARK(BM_RedetectRegion)
+    ->Apply(imageArguments)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_BuildContourLabelMap(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(buildContourLabelMap(
+        fixture.contours, fixture.image.rows, fixture.image.cols));
+  }
+  setPixelsProcessed(state, fixture);
+}
+BENCHMARK(BM_BuildContourLabelMap)
+    ->Apply(imageArguments)
+    ->Unit(benchmark::kMillisecond);
+
+void BM_ClickedContourNumberScan(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  size_t i{0};
+  for (auto _ : state) {
+    const cv::Point &click{fixture.clicks[i++ % fixture.clicks.size()]};
+    benchmark::DoNotOptimize(
+        clickedContourNumber(fixture.contours, click.x, click.y));
+  }
+  state.counters["contours"] =
+      static_cast<double>(fixture.contours.size());
+}
+BENCHMARK(BM_ClickedContourNumberScan)->Apply(imageArguments);
+
+void BM_ClickedContourNumberLabelMap(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  size_t i{0};
+  for (auto _ : state) {
+    const cv::Point &click{fixture.clicks[i++ % fixture.clicks.size()]};
+    benchmark::DoNotOptimize(
+        clickedContourNumber(fixture.label_map, click.x, click.y));
+  }
+  state.counters["contours"] =
+      static_cast<double>(fixture.contours.size());
+}
+BENCHMARK(BM_ClickedContourNumberLabelMap)->Apply(imageArguments);
+
+void BM_FilterContours(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  ContourFilter filter{};
+  filter.min_area = 100.0;
+  filter.min_solidity = 0.9;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filterContours(fixture.contours, filter,
+                                            ContourOrder::AreaDescending));
+  }
+  state.counters["contours"] =
+      static_cast<double>(fixture.contours.size());
+}
+BENCHMARK(BM_FilterContours)->Apply(imageArguments);
+
+// Every iteration is a frame where all objects stayed in place, matched
+// against the tracks of the previous one.
+void BM_TrackContours(benchmark::State &state) {
+  const Fixture &fixture{::fixture(state)};
+  ContourTracker tracker{};
+  tracker.update(fixture.contours);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(tracker.update(fixture.contours));
+  }
+  state.counters["contours"] =
+      static_cast<double>(fixture.contours.size());
+}
+BENCHMARK(BM_TrackContours)->Apply(imageArguments);
+
+// Connection to the stand-in database, or nullptr if there is none.
+pqxx::connection *benchConnection() {
+  static std::unique_ptr<pqxx::connection> conn{[]() {
+    const char *conn_string{std::getenv("CONTOURS_BENCH_DB")};
+    if (conn_string == nullptr) {
+      return std::unique_ptr<pqxx::connection>{};
+    }
+    try {
+      auto conn{std::make_unique<pqxx::connection>(conn_string)};
+      prepareStatements(*conn);
+      return conn;
+    } catch (...) {
+      return std::unique_ptr<pqxx::connection>{};
+    }
+  }()};
+
+  return conn.get();
+}
+
+std::unordered_map<int, std::string> makeContourNames(int64_t count) {
+  std::unordered_map<int, std::string> names{};
+  for (int i = 0; i != count; ++i) {
+    names[i] = "Contour " + std::to_string(i);
+  }
+
+  return names;
+}
+
+std::vector<ContourSummary> makeSummaries(int64_t count) {
+  std::vector<ContourSummary> summaries{};
+  for (int i = 0; i != count; ++i) {
+    summaries.push_back({i, i, 10, 10, 78.5});
+  }
+
+  return summaries;
+}
+
+void BM_AddContoursToDb(benchmark::State &state) {
+  pqxx::connection *conn{benchConnection()};
+  if (conn == nullptr) {
+    state.SkipWithError("CONTOURS_BENCH_DB is not set or unreachable");
+    return;
+  }
+  std::unordered_map<int, std::string> names{makeContourNames(state.range(0))};
+  std::vector<ContourSummary> summaries{makeSummaries(state.range(0))};
+  for (auto _ : state) {
+    if (!addContoursToDb(*conn, "/bench/bench_image", "bench_image", names,
+                         summaries)) {
+      state.SkipWithError("saving contours failed");
+      break;
+    }
+  }
+}
+BENCHMARK(BM_AddContoursToDb)
+    ->ArgName("contours")
+    ->Arg(16)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_GetContoursFromDb(benchmark::State &state) {
+  pqxx::connection *conn{benchConnection()};
+  if (conn == nullptr) {
+    state.SkipWithError("CONTOURS_BENCH_DB is not set or unreachable");
+    return;
+  }
+  if (!addContoursToDb(*conn, "/bench/bench_image", "bench_image",
+                       makeContourNames(state.range(0)),
+                       makeSummaries(state.range(0)))) {
+    state.SkipWithError("saving contours failed");
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getContoursFromDb(*conn, "/bench/bench_image", "bench_image"));
+  }
+}
+BENCHMARK(BM_GetContoursFromDb)
+    ->ArgName("contours")
+    ->Arg(16)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+std::vector<ImageContours> makeBatch(int64_t image_count) {
+  std::vector<ImageContours> images{};
+  for (int i = 0; i != image_count; ++i) {
+    std::string name{"bench_batch_" + std::to_string(i)};
+    images.push_back(
+        {"/bench/" + name, name, makeContourNames(16), makeSummaries(16)});
+  }
+
+  return images;
+}
+
+void BM_AddContoursToDbBatch(benchmark::State &state) {
+  pqxx::connection *conn{benchConnection()};
+  if (conn == nullptr) {
+    state.SkipWithError("CONTOURS_BENCH_DB is not set or unreachable");
+    return;
+  }
+  auto images{makeBatch(state.range(0))};
+  for (auto _ : state) {
+    if (!addContoursToDbBatch(*conn, images)) {
+      state.SkipWithError("saving contours failed");
+      break;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AddContoursToDbBatch)
+    ->ArgName("images")
+    ->Arg(16)
+    ->Arg(128)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+void BM_GetContoursFromDbBatch(benchmark::State &state) {
+  pqxx::connection *conn{benchConnection()};
+  if (conn == nullptr) {
+    state.SkipWithError("CONTOURS_BENCH_DB is not set or unreachable");
+    return;
+  }
+  auto images{makeBatch(state.range(0))};
+  if (!addContoursToDbBatch(*conn, images)) {
+    state.SkipWithError("saving contours failed");
+    return;
+  }
+  std::vector<std::string> image_paths{};
+  for (const ImageContours &image : images) {
+    image_paths.push_back(image.image_path);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(getContoursFromDbBatch(*conn, image_paths));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GetContoursFromDbBatch)
+    ->ArgName("images")
+    ->Arg(16)
+    ->Arg(128)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+} // namespace
+
+BENCHMARK_MAIN();
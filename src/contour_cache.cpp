@@ -0,0 +1,179 @@
+#include "contour_cache.h"
+#include "contour_codec.h"
+#include "image_hash.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace {
+// Every entry file starts with the magic and the codec version; entries of
+// another version are treated as missing.
+constexpr char kMagic[4]{'C', 'T', 'R', 'C'};
+constexpr uint8_t kVersion{1};
+constexpr const char *kExtension{".ctrc"};
+} // namespace
+
+/**
+ * @brief Opens the cache in the directory, creating it if needed, and indexes
+ *        the entries already there.
+ *
+ * @param directory Directory holding the entry files;
+ * @param max_bytes Size the entries are kept under.
+ */
+ContourCache::ContourCache(const std::string &directory, uint64_t max_bytes)
+    : m_directory{directory}, m_max_bytes{max_bytes} {
+  std::error_code error{};
+  std::filesystem::create_directories(m_directory, error);
+
+  std::vector<std::pair<std::filesystem::file_time_type, std::string>> found{};
+  for (const std::filesystem::directory_entry &file :
+       std::filesystem::directory_iterator(m_directory, error)) {
+    if (file.path().extension() != kExtension) {
+      continue;
+    }
+    found.emplace_back(file.last_write_time(error),
+                       file.path().stem().string());
+  }
+  std::sort(found.begin(), found.end(),
+            [](const auto &a, const auto &b) { return a.first > b.first; });
+
+  for (const auto &[time, key] : found) {
+    uint64_t size{std::filesystem::file_size(entryPath(key), error)};
+    if (error) {
+      continue;
+    }
+    m_recency.push_back(key);
+    m_entries[key] = Entry{std::prev(m_recency.end()), size};
+    m_size += size;
+  }
+  evict();
+}
+
+/**
+ * @brief Builds the key of a detection result.
+ *
+ * @param image_hash Image's content hash;
+ * @param parameters Detector and preprocessing settings the contours depend
+ *        on;
+ * @param img_height Height of the image detection ran on;
+ * @param img_width Width of the image detection ran on.
+ * @return Key usable as a file name.
+ */
+std::string ContourCache::makeKey(const std::string &image_hash,
+                                  const std::string &parameters,
+                                  int img_height, int img_width) {
+  std::string description{image_hash + '\n' + parameters + '\n' +
+                          std::to_string(img_height) + 'x' +
+                          std::to_string(img_width)};
+
+  return hashImageData(
+      QByteArray(description.data(), static_cast<int>(description.size())));
+}
+
+/**
+ * @brief Looks an entry up and marks it as recently used.
+ *
+ * @param key Key built by makeKey;
+ * @param contours Receives the cached contours.
+ * @return Whether the entry has been found and read.
+ */
+bool ContourCache::get(const std::string &key, ContourStore &contours) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto it{m_entries.find(key)};
+  if (it == m_entries.end()) {
+    return false;
+  }
+
+  std::ifstream file{entryPath(key), std::ios::binary};
+  std::vector<uint8_t> data{std::istreambuf_iterator<char>(file),
+                            std::istreambuf_iterator<char>()};
+  if (data.size() < sizeof(kMagic) + 1 ||
+      std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0 ||
+      data[sizeof(kMagic)] != kVersion ||
+      !decodeContours(data.data() + sizeof(kMagic) + 1,
+                      data.size() - sizeof(kMagic) - 1, contours)) {
+    erase(key);
+    return false;
+  }
+
+  m_recency.splice(m_recency.begin(), m_recency, it->second.recency);
+  std::error_code error{};
+  std::filesystem::last_write_time(
+      entryPath(key), std::filesystem::file_time_type::clock::now(), error);
+
+  return true;
+}
+
+/**
+ * @brief Adds or replaces an entry, evicting the least recently used ones
+ *        if the cache grows over its size.
+ *
+ * @param key Key built by makeKey;
+ * @param contours Contours to cache.
+ */
+void ContourCache::put(const std::string &key,
+                       const ContourStore &contours) {
+  std::vector<uint8_t> data{kMagic, kMagic + sizeof(kMagic)};
+  data.push_back(kVersion);
+  std::vector<uint8_t> encoded{encodeContours(contours)};
+  data.insert(data.end(), encoded.begin(), encoded.end());
+
+  std::lock_guard<std::mutex> lock{m_mutex};
+  // Written aside and renamed, so that a crash never leaves a torn entry.
+  std::filesystem::path path{entryPath(key)};
+  std::filesystem::path temp_path{path};
+  temp_path += ".tmp";
+  {
+    std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+    file.write(reinterpret_cast<const char *>(data.data()), data.size());
+    if (!file) {
+      return;
+    }
+  }
+  std::error_code error{};
+  std::filesystem::rename(temp_path, path, error);
+  if (error) {
+    std::filesystem::remove(temp_path, error);
+    return;
+  }
+
+  auto it{m_entries.find(key)};
+  if (it != m_entries.end()) {
+    m_size -= it->second.size;
+    m_recency.erase(it->second.recency);
+  }
+  m_recency.push_front(key);
+  m_entries[key] = Entry{m_recency.begin(), data.size()};
+  m_size += data.size();
+  evict();
+}
+
+uint64_t ContourCache::sizeBytes() {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  return m_size;
+}
+
+std::filesystem::path ContourCache::entryPath(const std::string &key) const {
+  return m_directory / (key + kExtension);
+}
+
+void ContourCache::erase(const std::string &key) {
+  auto it{m_entries.find(key)};
+  if (it == m_entries.end()) {
+    return;
+  }
+
+  std::error_code error{};
+  std::filesystem::remove(entryPath(key), error);
+  m_size -= it->second.size;
+  m_recency.erase(it->second.recency);
+  m_entries.erase(it);
+}
+
+void ContourCache::evict() {
+  while (m_size > m_max_bytes && !m_recency.empty()) {
+    std::string key{m_recency.back()};
+    erase(key);
+  }
+}
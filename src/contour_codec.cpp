@@ -0,0 +1,105 @@
+#include "contour_codec.h"
+
+// Contours are stored as LEB128 varints: the number of contours, then for
+// every contour its number of points followed by its points. The first point
+// is stored as is and every next one as the difference to the previous one,
+// zigzag encoded so that small negative steps stay small. Since
+// CHAIN_APPROX_SIMPLE leaves mostly short steps, most coordinates take a
+// single byte instead of the four of an int.
+
+void writeVarint(std::vector<uint8_t> &out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+bool readVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    if (data == end) {
+      return false;
+    }
+    uint8_t byte{*data++};
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/**
+ * @brief Packs contours into a compact byte string.
+ *
+ * @param contours Contours to encode.
+ * @return Encoded contours.
+ */
+std::vector<uint8_t> encodeContours(const ContourStore &contours) {
+  std::vector<uint8_t> out{};
+  writeVarint(out, contours.size());
+  for (size_t i = 0; i != contours.size(); ++i) {
+    ContourPoints contour{contours[i]};
+    writeVarint(out, contour.size);
+    cv::Point previous{0, 0};
+    for (const cv::Point &point : contour) {
+      writeVarint(out, zigzagEncode(point.x - previous.x));
+      writeVarint(out, zigzagEncode(point.y - previous.y));
+      previous = point;
+    }
+  }
+
+  return out;
+}
+
+/**
+ * @brief Unpacks contours encoded by encodeContours. Their features are
+ *        computed again as they are added to the store.
+ *
+ * @param data Encoded contours;
+ * @param size Size of the data in bytes;
+ * @param contours Receives the contours.
+ * @return Whether the data has been decoded successfully.
+ */
+bool decodeContours(const uint8_t *data, size_t size, ContourStore &contours) {
+  const uint8_t *end{data + size};
+  contours.clear();
+
+  uint64_t contour_count{};
+  // Every contour takes at least one byte, and every point two, which bounds
+  // the reservation.
+  if (!readVarint(data, end, contour_count) ||
+      contour_count > static_cast<uint64_t>(end - data)) {
+    return false;
+  }
+  contours.reserve(contour_count, static_cast<size_t>(end - data) / 2);
+
+  // Points are decoded into one buffer, reused from contour to contour.
+  std::vector<cv::Point> contour{};
+  for (uint64_t i = 0; i != contour_count; ++i) {
+    uint64_t point_count{};
+    if (!readVarint(data, end, point_count) ||
+        point_count > static_cast<uint64_t>(end - data) / 2) {
+      return false;
+    }
+    contour.resize(point_count);
+
+    int64_t x{0};
+    int64_t y{0};
+    for (cv::Point &point : contour) {
+      uint64_t dx{};
+      uint64_t dy{};
+      if (!readVarint(data, end, dx) || !readVarint(data, end, dy)) {
+        return false;
+      }
+      x += zigzagDecode(dx);
+      y += zigzagDecode(dy);
+      point = cv::Point(static_cast<int>(x), static_cast<int>(y));
+    }
+    contours.append(contour);
+  }
+
+  return data == end;
+}
@@ -0,0 +1,155 @@
+#include "contour_export.h"
+
+#include <fstream>
+#include <limits>
+#include <locale>
+
+// Both formats keep image coordinates: x to the right and y down, in pixels
+// of the image detection ran on. Contours are numbered within their image,
+// as in the .contours files.
+
+namespace {
+void openExport(std::ofstream &file, const std::string &file_path) {
+  file.open(file_path);
+  // Decimal points whatever the user's locale, and doubles that read back
+  // the same.
+  file.imbue(std::locale::classic());
+  file.precision(std::numeric_limits<double>::max_digits10);
+}
+
+void writeJsonString(std::ofstream &file, std::string_view text) {
+  const char *hex{"0123456789abcdef"};
+  file << '"';
+  for (char c : text) {
+    unsigned char byte{static_cast<unsigned char>(c)};
+    if (c == '"' || c == '\\') {
+      file << '\\' << c;
+    } else if (byte < 0x20) {
+      file << "\\u00" << hex[byte >> 4] << hex[byte & 0xF];
+    } else {
+      file << c;
+    }
+  }
+  file << '"';
+}
+
+void writeCsvField(std::ofstream &file, std::string_view text) {
+  file << '"';
+  for (char c : text) {
+    if (c == '"') {
+      file << '"';
+    }
+    file << c;
+  }
+  file << '"';
+}
+} // namespace
+
+/**
+ * @brief Writes every contour of an archive as a GeoJSON feature: a polygon,
+ *        or a line string or a point for contours of fewer than three
+ *        points, with the image name, contour number, area and perimeter as
+ *        properties.
+ *
+ * @param archive Opened archive;
+ * @param file_path Output file.
+ * @return Whether every contour has been read and the file written.
+ */
+bool exportGeoJson(const ContourArchive &archive,
+                   const std::string &file_path) {
+  std::ofstream file{};
+  openExport(file, file_path);
+  if (!file) {
+    return false;
+  }
+
+  file << "{\"type\":\"FeatureCollection\",\"features\":[";
+  bool first_feature{true};
+  std::vector<cv::Point> points{};
+  for (size_t i = 0; i != archive.imageCount(); ++i) {
+    const ArchiveImage &image{archive.image(i)};
+    for (uint64_t j = 0; j != image.contour_count; ++j) {
+      size_t index{static_cast<size_t>(image.first_contour + j)};
+      if (!archive.readPoints(index, points) || points.empty()) {
+        return false;
+      }
+      const ArchiveContour &contour{archive.contour(index)};
+
+      file << (first_feature ? "\n" : ",\n")
+           << "{\"type\":\"Feature\",\"properties\":{\"image\":";
+      first_feature = false;
+      writeJsonString(file, archive.imageName(i));
+      file << ",\"contour\":" << j << ",\"area\":" << contour.area
+           << ",\"perimeter\":" << contour.perimeter << "},\"geometry\":";
+      if (points.size() == 1) {
+        file << "{\"type\":\"Point\",\"coordinates\":[" << points[0].x << ','
+             << points[0].y << "]}}";
+        continue;
+      }
+      // Polygon rings are closed by repeating the first point.
+      bool polygon{points.size() >= 3};
+      if (polygon) {
+        points.push_back(points.front());
+      }
+      file << (polygon ? "{\"type\":\"Polygon\",\"coordinates\":[["
+                       : "{\"type\":\"LineString\",\"coordinates\":[");
+      for (size_t k = 0; k != points.size(); ++k) {
+        file << (k == 0 ? "[" : ",[") << points[k].x << ',' << points[k].y
+             << ']';
+      }
+      file << (polygon ? "]]}}" : "]}}");
+    }
+  }
+  file << "\n]}\n";
+
+  return static_cast<bool>(file);
+}
+
+/**
+ * @brief Writes one row per contour of an archive: image name, contour
+ *        number, bounding box, area, perimeter and the contour as WKT.
+ *
+ * @param archive Opened archive;
+ * @param file_path Output file.
+ * @return Whether every contour has been read and the file written.
+ */
+bool exportCsv(const ContourArchive &archive, const std::string &file_path) {
+  std::ofstream file{};
+  openExport(file, file_path);
+  if (!file) {
+    return false;
+  }
+
+  file << "image,contour,x,y,width,height,area,perimeter,wkt\n";
+  std::vector<cv::Point> points{};
+  for (size_t i = 0; i != archive.imageCount(); ++i) {
+    const ArchiveImage &image{archive.image(i)};
+    for (uint64_t j = 0; j != image.contour_count; ++j) {
+      size_t index{static_cast<size_t>(image.first_contour + j)};
+      if (!archive.readPoints(index, points) || points.empty()) {
+        return false;
+      }
+      const ArchiveContour &contour{archive.contour(index)};
+
+      writeCsvField(file, archive.imageName(i));
+      file << ',' << j << ',' << contour.x << ',' << contour.y << ','
+           << contour.width << ',' << contour.height << ',' << contour.area
+           << ',' << contour.perimeter << ",\"";
+      if (points.size() == 1) {
+        file << "POINT (" << points[0].x << ' ' << points[0].y << ")\"\n";
+        continue;
+      }
+      bool polygon{points.size() >= 3};
+      if (polygon) {
+        points.push_back(points.front());
+      }
+      file << (polygon ? "POLYGON ((" : "LINESTRING (");
+      for (size_t k = 0; k != points.size(); ++k) {
+        file << (k == 0 ? "" : ", ") << points[k].x << ' ' << points[k].y;
+      }
+      file << (polygon ? "))\"\n" : ")\"\n");
+    }
+  }
+
+  return static_cast<bool>(file);
+}
@@ -0,0 +1,77 @@
+#include "contour_filter.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+/**
+ * @brief Picks the contours within the filter's bounds and orders them. Reads
+ *        only the precomputed features, never the points, so it is cheap
+ *        enough to run on every change of the filter.
+ *
+ * @param contours Contours with their features;
+ * @param filter Bounds to apply;
+ * @param order Order of the result.
+ * @return Numbers of the contours passing the filter, in the given order.
+ */
+std::vector<int> filterContours(const ContourStore &contours,
+                                const ContourFilter &filter,
+                                ContourOrder order) {
+  PROFILE_SCOPE("filter contours");
+  const std::vector<cv::Rect> &bboxes{contours.bboxes()};
+  const std::vector<double> &areas{contours.areas()};
+  const std::vector<double> &solidities{contours.solidities()};
+  bool check_region{!filter.region.empty()};
+
+  std::vector<int> numbers{};
+  numbers.reserve(contours.size());
+  for (int i = 0; i != static_cast<int>(contours.size()); ++i) {
+    if (areas[i] < filter.min_area ||
+        (filter.max_area > 0.0 && areas[i] > filter.max_area) ||
+        solidities[i] < filter.min_solidity) {
+      continue;
+    }
+    double aspect_ratio{static_cast<double>(bboxes[i].width) /
+                        bboxes[i].height};
+    if (aspect_ratio < filter.min_aspect_ratio ||
+        (filter.max_aspect_ratio > 0.0 &&
+         aspect_ratio > filter.max_aspect_ratio)) {
+      continue;
+    }
+    if (check_region && (bboxes[i] & filter.region).empty()) {
+      continue;
+    }
+    numbers.push_back(i);
+  }
+
+  // Stable, so that ties keep the detection order.
+  switch (order) {
+  case ContourOrder::Detection:
+    break;
+  case ContourOrder::AreaDescending:
+    std::stable_sort(numbers.begin(), numbers.end(),
+                     [&areas](int a, int b) { return areas[a] > areas[b]; });
+    break;
+  case ContourOrder::AreaAscending:
+    std::stable_sort(numbers.begin(), numbers.end(),
+                     [&areas](int a, int b) { return areas[a] < areas[b]; });
+    break;
+  case ContourOrder::PerimeterDescending: {
+    const std::vector<double> &perimeters{contours.perimeters()};
+    std::stable_sort(numbers.begin(), numbers.end(),
+                     [&perimeters](int a, int b) {
+                       return perimeters[a] > perimeters[b];
+                     });
+    break;
+  }
+  case ContourOrder::TopToBottom:
+    std::stable_sort(numbers.begin(), numbers.end(),
+                     [&bboxes](int a, int b) {
+                       return bboxes[a].y != bboxes[b].y
+                                  ? bboxes[a].y < bboxes[b].y
+                                  : bboxes[a].x < bboxes[b].x;
+                     });
+    break;
+  }
+
+  return numbers;
+}
@@ -0,0 +1,118 @@
+#include "contour_filter_panel.h"
+
+#include <QGridLayout>
+#include <QLabel>
+
+namespace {
+// Spin boxes show "Any" at 0, where the bound is not applied.
+QDoubleSpinBox *createBoundBox(double maximum, double step, int decimals,
+                               QWidget *parent) {
+  QDoubleSpinBox *box = new QDoubleSpinBox{parent};
+  box->setRange(0.0, maximum);
+  box->setSingleStep(step);
+  box->setDecimals(decimals);
+  box->setSpecialValueText("Any");
+  box->setKeyboardTracking(false);
+
+  return box;
+}
+} // namespace
+
+ContourFilterPanel::ContourFilterPanel(QWidget *parent) : QWidget(parent) {
+  min_area_box = createBoundBox(1e9, 50.0, 0, this);
+  min_area_box->setSuffix(" px²");
+  max_area_box = createBoundBox(1e9, 50.0, 0, this);
+  max_area_box->setSuffix(" px²");
+  min_aspect_box = createBoundBox(100.0, 0.1, 2, this);
+  max_aspect_box = createBoundBox(100.0, 0.1, 2, this);
+  min_solidity_box = createBoundBox(1.0, 0.05, 2, this);
+  in_view_check = new QCheckBox{"Only in view", this};
+  order_combo = new QComboBox{this};
+  order_combo->addItem("Detection order",
+                       static_cast<int>(ContourOrder::Detection));
+  order_combo->addItem("Largest first",
+                       static_cast<int>(ContourOrder::AreaDescending));
+  order_combo->addItem("Smallest first",
+                       static_cast<int>(ContourOrder::AreaAscending));
+  order_combo->addItem("Longest outline first",
+                       static_cast<int>(ContourOrder::PerimeterDescending));
+  order_combo->addItem("Top to bottom",
+                       static_cast<int>(ContourOrder::TopToBottom));
+  reset_button = new QPushButton{"Reset", this};
+
+  QGridLayout *layout = new QGridLayout{this};
+  layout->setContentsMargins(0, 0, 0, 0);
+  layout->addWidget(new QLabel{"Area from", this}, 0, 0);
+  layout->addWidget(min_area_box, 0, 1);
+  layout->addWidget(new QLabel{"to", this}, 0, 2);
+  layout->addWidget(max_area_box, 0, 3);
+  layout->addWidget(new QLabel{"Aspect from", this}, 1, 0);
+  layout->addWidget(min_aspect_box, 1, 1);
+  layout->addWidget(new QLabel{"to", this}, 1, 2);
+  layout->addWidget(max_aspect_box, 1, 3);
+  layout->addWidget(new QLabel{"Solidity from", this}, 2, 0);
+  layout->addWidget(min_solidity_box, 2, 1);
+  layout->addWidget(in_view_check, 2, 2, 1, 2);
+  layout->addWidget(new QLabel{"Sort", this}, 3, 0);
+  layout->addWidget(order_combo, 3, 1, 1, 2);
+  layout->addWidget(reset_button, 3, 3);
+
+  for (QDoubleSpinBox *box : {min_area_box, max_area_box, min_aspect_box,
+                              max_aspect_box, min_solidity_box}) {
+    connect(box, &QDoubleSpinBox::valueChanged, this,
+            &ContourFilterPanel::reportChange);
+  }
+  connect(in_view_check, &QCheckBox::toggled, this,
+          &ContourFilterPanel::reportChange);
+  connect(order_combo, &QComboBox::currentIndexChanged, this,
+          &ContourFilterPanel::reportChange);
+  connect(reset_button, &QPushButton::clicked, this,
+          &ContourFilterPanel::resetFilter);
+}
+
+ContourFilterPanel::~ContourFilterPanel() {}
+
+/**
+ * @brief Bounds set in the panel. The region is left empty: the view it
+ *        stands for belongs to the caller.
+ */
+ContourFilter ContourFilterPanel::filter() const {
+  ContourFilter filter{};
+  filter.min_area = min_area_box->value();
+  filter.max_area = max_area_box->value();
+  filter.min_aspect_ratio = min_aspect_box->value();
+  filter.max_aspect_ratio = max_aspect_box->value();
+  filter.min_solidity = min_solidity_box->value();
+
+  return filter;
+}
+
+ContourOrder ContourFilterPanel::order() const {
+  return static_cast<ContourOrder>(order_combo->currentData().toInt());
+}
+
+bool ContourFilterPanel::limitedToView() const {
+  return in_view_check->isChecked();
+}
+
+/**
+ * @brief Clears every bound at once, reporting a single change.
+ */
+void ContourFilterPanel::resetFilter() {
+  m_resetting = true;
+  min_area_box->setValue(0.0);
+  max_area_box->setValue(0.0);
+  min_aspect_box->setValue(0.0);
+  max_aspect_box->setValue(0.0);
+  min_solidity_box->setValue(0.0);
+  in_view_check->setChecked(false);
+  order_combo->setCurrentIndex(0);
+  m_resetting = false;
+  emit filterChanged();
+}
+
+void ContourFilterPanel::reportChange() {
+  if (!m_resetting) {
+    emit filterChanged();
+  }
+}
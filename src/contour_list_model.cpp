@@ -0,0 +1,204 @@
+#include "contour_list_model.h"
+#include "contour_detection.h"
+
+#include <algorithm>
+
+namespace {
+// Selected rows as sorted, disjoint [top, bottom] ranges. A selection can
+// hold overlapping ranges after toggling clicks.
+std::vector<std::pair<int, int>> rowRanges(const QItemSelection &selection) {
+  std::vector<std::pair<int, int>> ranges{};
+  for (const QItemSelectionRange &range : selection) {
+    ranges.emplace_back(range.top(), range.bottom());
+  }
+  std::sort(ranges.begin(), ranges.end());
+
+  std::vector<std::pair<int, int>> merged{};
+  for (const auto &range : ranges) {
+    if (!merged.empty() && range.first <= merged.back().second + 1) {
+      merged.back().second = std::max(merged.back().second, range.second);
+    } else {
+      merged.push_back(range);
+    }
+  }
+
+  return merged;
+}
+} // namespace
+
+ContourListModel::ContourListModel(QString title, QObject *parent)
+    : QAbstractTableModel(parent), m_title{std::move(title)} {}
+
+int ContourListModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : 1;
+}
+
+QVariant ContourListModel::headerData(int section, Qt::Orientation orientation,
+                                      int role) const {
+  if (role != Qt::DisplayRole) {
+    return {};
+  }
+
+  return orientation == Qt::Horizontal ? QVariant{m_title}
+                                       : QVariant{section + 1};
+}
+
+/**
+ * @brief Contour numbers of the selected rows. Selections are kept as row
+ *        ranges, so no per-row items are created.
+ *
+ * @param selection Selection of a view showing the model.
+ * @return Contour numbers, in row order.
+ */
+std::vector<int>
+ContourListModel::contourNumbers(const QItemSelection &selection) const {
+  std::vector<int> numbers{};
+  for (const auto &[top, bottom] : rowRanges(selection)) {
+    for (int row = top; row <= bottom; ++row) {
+      numbers.push_back(contourNumber(row));
+    }
+  }
+
+  return numbers;
+}
+
+QVariant ContourListModel::contourColor(int row) const {
+  return hueToRgbaQColor(80 * contourNumber(row) % 360, 63);
+}
+
+FoundContoursModel::FoundContoursModel(QObject *parent)
+    : ContourListModel("All Found Contours", parent) {}
+
+int FoundContoursModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : static_cast<int>(m_numbers.size());
+}
+
+QVariant FoundContoursModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid()) {
+    return {};
+  }
+
+  switch (role) {
+  case Qt::DisplayRole:
+    return contourLabel(contourNumber(index.row()));
+  case Qt::BackgroundRole:
+    return contourColor(index.row());
+  case Qt::UserRole:
+    return contourNumber(index.row());
+  default:
+    return {};
+  }
+}
+
+/**
+ * @brief Name a found contour is listed under, and saved under by default.
+ */
+QString FoundContoursModel::contourLabel(int number) {
+  return tr("Contour №%1").arg(number + 1);
+}
+
+/**
+ * @brief Row a contour is listed at.
+ *
+ * @param number Contour number.
+ * @return Row, or -1 if the contour is filtered out.
+ */
+int FoundContoursModel::contourRow(int number) const {
+  if (number < 0 || number >= static_cast<int>(m_rows.size())) {
+    return -1;
+  }
+
+  return m_rows[number];
+}
+
+/**
+ * @brief Lists the given contours, in the given order.
+ */
+void FoundContoursModel::setContourNumbers(std::vector<int> numbers) {
+  beginResetModel();
+  m_numbers = std::move(numbers);
+  int max_number{-1};
+  for (int number : m_numbers) {
+    max_number = std::max(max_number, number);
+  }
+  m_rows.assign(max_number + 1, -1);
+  for (int row = 0; row != static_cast<int>(m_numbers.size()); ++row) {
+    m_rows[m_numbers[row]] = row;
+  }
+  endResetModel();
+}
+
+SavedContoursModel::SavedContoursModel(QObject *parent)
+    : ContourListModel("Saved Contours", parent) {}
+
+int SavedContoursModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+QVariant SavedContoursModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid()) {
+    return {};
+  }
+
+  switch (role) {
+  case Qt::DisplayRole:
+  case Qt::EditRole:
+    return QString::fromStdString(m_rows[index.row()].second);
+  case Qt::BackgroundRole:
+    return contourColor(index.row());
+  case Qt::UserRole:
+    return m_rows[index.row()].first;
+  default:
+    return {};
+  }
+}
+
+bool SavedContoursModel::setData(const QModelIndex &index,
+                                 const QVariant &value, int role) {
+  if (!index.isValid() || role != Qt::EditRole) {
+    return false;
+  }
+
+  m_rows[index.row()].second = value.toString().toStdString();
+  emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+
+  return true;
+}
+
+Qt::ItemFlags SavedContoursModel::flags(const QModelIndex &index) const {
+  return ContourListModel::flags(index) | Qt::ItemIsEditable;
+}
+
+void SavedContoursModel::setContours(
+    std::vector<std::pair<int, std::string>> contours) {
+  beginResetModel();
+  m_rows = std::move(contours);
+  endResetModel();
+}
+
+void SavedContoursModel::appendContours(
+    const std::vector<std::pair<int, std::string>> &contours) {
+  if (contours.empty()) {
+    return;
+  }
+
+  int first{static_cast<int>(m_rows.size())};
+  beginInsertRows(QModelIndex(), first,
+                  first + static_cast<int>(contours.size()) - 1);
+  m_rows.insert(m_rows.end(), contours.begin(), contours.end());
+  endInsertRows();
+}
+
+/**
+ * @brief Removes the selected rows, one contiguous range at a time.
+ */
+void SavedContoursModel::removeContours(const QItemSelection &selection) {
+  std::vector<std::pair<int, int>> ranges{rowRanges(selection)};
+  // Bottom ranges first, so that the rows of the others stay put.
+  for (auto it = ranges.rbegin(); it != ranges.rend(); ++it) {
+    auto [top, bottom] = *it;
+    beginRemoveRows(QModelIndex(), top, bottom);
+    m_rows.erase(m_rows.begin() + top, m_rows.begin() + bottom + 1);
+    endRemoveRows();
+  }
+}
@@ -0,0 +1,161 @@
+#include "contour_store.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+/**
+ * @brief Wraps the points in a CV_32SC2 matrix without copying them, for
+ *        OpenCV functions taking a contour. The matrix must not be written to.
+ */
+cv::Mat ContourPoints::mat() const {
+  return cv::Mat(static_cast<int>(size), 1, CV_32SC2,
+                 const_cast<cv::Point *>(data));
+}
+
+/**
+ * @brief Builds a store from contours as cv::findContours returns them.
+ */
+ContourStore::ContourStore(
+    const std::vector<std::vector<cv::Point>> &contours) {
+  assign(contours);
+}
+
+/**
+ * @brief Replaces the contours with those given, keeping the allocated
+ *        storage.
+ */
+void ContourStore::assign(
+    const std::vector<std::vector<cv::Point>> &contours) {
+  clear();
+  size_t point_count{0};
+  for (const std::vector<cv::Point> &contour : contours) {
+    point_count += contour.size();
+  }
+  reserve(contours.size(), point_count);
+  for (const std::vector<cv::Point> &contour : contours) {
+    append(contour);
+  }
+}
+
+void ContourStore::reserve(size_t contour_count, size_t point_count) {
+  m_points.reserve(point_count);
+  m_offsets.reserve(contour_count + 1);
+  m_bboxes.reserve(contour_count);
+  m_areas.reserve(contour_count);
+  m_perimeters.reserve(contour_count);
+  m_solidities.reserve(contour_count);
+  m_centroids.reserve(contour_count);
+  m_moments.reserve(contour_count);
+}
+
+/**
+ * @brief Adds a contour and computes its features. The bounding box and the
+ *        perimeter are gathered in a single walk over the points; area and
+ *        centroid derive from the moments, solidity from the convex hull.
+ *
+ * @param points Contour's points;
+ * @param count Number of points.
+ */
+void ContourStore::append(const cv::Point *points, size_t count) {
+  m_points.insert(m_points.end(), points, points + count);
+  m_offsets.push_back(m_points.size());
+
+  if (count == 0) {
+    m_bboxes.emplace_back();
+    m_areas.push_back(0.0);
+    m_perimeters.push_back(0.0);
+    m_solidities.push_back(1.0);
+    m_centroids.emplace_back();
+    m_moments.emplace_back();
+    return;
+  }
+
+  int min_x{INT_MAX};
+  int min_y{INT_MAX};
+  int max_x{INT_MIN};
+  int max_y{INT_MIN};
+  double perimeter{0.0};
+  // Closed contour: the walk starts from the edge joining the last point to
+  // the first, as cv::arcLength does.
+  cv::Point previous{points[count - 1]};
+  for (size_t i = 0; i != count; ++i) {
+    const cv::Point &point{points[i]};
+    min_x = std::min(min_x, point.x);
+    min_y = std::min(min_y, point.y);
+    max_x = std::max(max_x, point.x);
+    max_y = std::max(max_y, point.y);
+    double dx{static_cast<double>(point.x - previous.x)};
+    double dy{static_cast<double>(point.y - previous.y)};
+    perimeter += std::sqrt(dx * dx + dy * dy);
+    previous = point;
+  }
+  cv::Rect bbox{min_x, min_y, max_x - min_x + 1, max_y - min_y + 1};
+
+  // For a contour, m00 is its non-negative area, the same as
+  // cv::contourArea.
+  cv::Mat contour{static_cast<int>(count), 1, CV_32SC2,
+                  const_cast<cv::Point *>(points)};
+  cv::Moments moments{cv::moments(contour)};
+  // Degenerate contours (lines, single points) have no area; the center of
+  // their bounding box stands in for the centroid.
+  cv::Point2d centroid{moments.m00 != 0.0
+                           ? cv::Point2d(moments.m10 / moments.m00,
+                                         moments.m01 / moments.m00)
+                           : cv::Point2d(bbox.x + (bbox.width - 1) / 2.0,
+                                         bbox.y + (bbox.height - 1) / 2.0)};
+
+  // Kept from contour to contour, so that adding one does not allocate.
+  thread_local std::vector<cv::Point> hull{};
+  cv::convexHull(contour, hull);
+  double hull_area{cv::contourArea(hull)};
+
+  m_bboxes.push_back(bbox);
+  m_areas.push_back(moments.m00);
+  m_perimeters.push_back(perimeter);
+  // Degenerate contours are their own hull.
+  m_solidities.push_back(hull_area > 0.0 ? moments.m00 / hull_area : 1.0);
+  m_centroids.push_back(centroid);
+  m_moments.push_back(moments);
+}
+
+/**
+ * @brief Copies a contour of another store, with its features, without
+ *        computing them again.
+ */
+void ContourStore::append(const ContourStore &other, size_t index) {
+  ContourPoints contour{other[index]};
+  m_points.insert(m_points.end(), contour.begin(), contour.end());
+  m_offsets.push_back(m_points.size());
+  m_bboxes.push_back(other.m_bboxes[index]);
+  m_areas.push_back(other.m_areas[index]);
+  m_perimeters.push_back(other.m_perimeters[index]);
+  m_solidities.push_back(other.m_solidities[index]);
+  m_centroids.push_back(other.m_centroids[index]);
+  m_moments.push_back(other.m_moments[index]);
+}
+
+void ContourStore::clear() {
+  m_points.clear();
+  m_offsets.assign(1, 0);
+  m_bboxes.clear();
+  m_areas.clear();
+  m_perimeters.clear();
+  m_solidities.clear();
+  m_centroids.clear();
+  m_moments.clear();
+}
+
+/**
+ * @brief Matrix headers over every contour, in the form cv::drawContours
+ *        takes. The points are not copied.
+ */
+std::vector<cv::Mat> ContourStore::mats() const {
+  std::vector<cv::Mat> mats{};
+  mats.reserve(size());
+  for (size_t i = 0; i != size(); ++i) {
+    mats.push_back((*this)[i].mat());
+  }
+
+  return mats;
+}
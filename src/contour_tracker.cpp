@@ -0,0 +1,121 @@
+#include "contour_tracker.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+double intersectionOverUnion(const cv::Rect &a, const cv::Rect &b) {
+  double intersection{static_cast<double>((a & b).area())};
+  if (intersection == 0.0) {
+    return 0.0;
+  }
+
+  return intersection / (a.area() + b.area() - intersection);
+}
+
+struct Candidate {
+  double iou{0.0};
+  double distance{0.0};
+  size_t track{0};
+  size_t contour{0};
+};
+} // namespace
+
+ContourTracker::ContourTracker(TrackerOptions options) : m_options{options} {}
+
+/**
+ * @brief Matches the contours of the next frame to the tracks of the
+ *        previous ones. Unmatched contours start new tracks; tracks unmatched
+ *        for longer than max_missed_frames end.
+ *
+ * @param contours Contours of the frame, with their features.
+ * @return Track of every contour, in the store's order.
+ */
+std::vector<TrackedContour>
+ContourTracker::update(const ContourStore &contours) {
+  PROFILE_SCOPE("track contours");
+  // Where every track is expected in this frame.
+  std::vector<cv::Rect> predicted_bboxes{};
+  std::vector<cv::Point2d> predicted_centroids{};
+  predicted_bboxes.reserve(m_tracks.size());
+  predicted_centroids.reserve(m_tracks.size());
+  for (const Track &track : m_tracks) {
+    cv::Point2d shift{track.velocity * (track.missed + 1)};
+    predicted_centroids.push_back(track.centroid + shift);
+    predicted_bboxes.push_back(
+        track.bbox + cv::Point(static_cast<int>(std::lround(shift.x)),
+                               static_cast<int>(std::lround(shift.y))));
+  }
+
+  // Every pair within reach, from the features alone. Boxes farther apart
+  // than the centroid distance allows are ruled out before anything else.
+  int reach{static_cast<int>(std::ceil(m_options.max_centroid_distance))};
+  std::vector<Candidate> candidates{};
+  for (size_t t = 0; t != m_tracks.size(); ++t) {
+    cv::Rect reach_bbox{predicted_bboxes[t].x - reach,
+                        predicted_bboxes[t].y - reach,
+                        predicted_bboxes[t].width + 2 * reach,
+                        predicted_bboxes[t].height + 2 * reach};
+    for (size_t c = 0; c != contours.size(); ++c) {
+      const cv::Rect &bbox{contours.bbox(c)};
+      if ((bbox & reach_bbox).empty()) {
+        continue;
+      }
+      double iou{intersectionOverUnion(predicted_bboxes[t], bbox)};
+      cv::Point2d offset{contours.centroid(c) - predicted_centroids[t]};
+      double distance{std::hypot(offset.x, offset.y)};
+      if (iou >= m_options.min_iou ||
+          distance <= m_options.max_centroid_distance) {
+        candidates.push_back({iou, distance, t, c});
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.iou != b.iou ? a.iou > b.iou : a.distance < b.distance;
+            });
+
+  std::vector<TrackedContour> tracked(contours.size());
+  std::vector<bool> track_matched(m_tracks.size(), false);
+  for (const Candidate &candidate : candidates) {
+    if (track_matched[candidate.track] ||
+        tracked[candidate.contour].track_id != -1) {
+      continue;
+    }
+    track_matched[candidate.track] = true;
+    Track &track{m_tracks[candidate.track]};
+    tracked[candidate.contour].track_id = track.id;
+
+    const cv::Point2d &centroid{contours.centroid(candidate.contour)};
+    track.velocity = (centroid - track.centroid) * (1.0 / (track.missed + 1));
+    track.centroid = centroid;
+    track.bbox = contours.bbox(candidate.contour);
+    track.missed = 0;
+  }
+
+  // Unmatched tracks age and end; their slots are compacted in place.
+  size_t kept{0};
+  for (size_t t = 0; t != m_tracks.size(); ++t) {
+    if (!track_matched[t] &&
+        ++m_tracks[t].missed > m_options.max_missed_frames) {
+      continue;
+    }
+    m_tracks[kept++] = m_tracks[t];
+  }
+  m_tracks.resize(kept);
+
+  for (size_t c = 0; c != contours.size(); ++c) {
+    if (tracked[c].track_id != -1) {
+      continue;
+    }
+    Track track{};
+    track.id = m_next_id++;
+    track.bbox = contours.bbox(c);
+    track.centroid = contours.centroid(c);
+    m_tracks.push_back(track);
+    tracked[c] = {track.id, true};
+  }
+
+  return tracked;
+}
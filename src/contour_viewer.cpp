@@ -0,0 +1,337 @@
+#include "contour_viewer.h"
+#include "contour_detection.h"
+#include "profiler.h"
+
+#include <QApplication>
+#include <QPainter>
+#include <QScrollBar>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Scene units are image pixels. Contour points are pixel indices, drawn at
+// the pixel's center.
+QPolygonF toPolygon(const cv::Point *points, size_t count) {
+  QPolygonF polygon{};
+  polygon.reserve(static_cast<int>(count));
+  for (size_t i = 0; i != count; ++i) {
+    polygon.append(QPointF(points[i].x + 0.5, points[i].y + 0.5));
+  }
+
+  return polygon;
+}
+
+// Outlines are 2 px wide.
+constexpr qreal kOutlineWidth{2.0};
+
+constexpr qreal kMinZoom{1.0 / 64};
+constexpr qreal kMaxZoom{32.0};
+} // namespace
+
+ContourItem::ContourItem(ContourPoints contour, const cv::Rect &bbox,
+                         int number)
+    : m_contour{contour},
+      m_color{hueToRgbaQColor(80 * number % 360, 255)} {
+  m_bounds = QRectF(bbox.x, bbox.y, bbox.width, bbox.height)
+                 .adjusted(-kOutlineWidth, -kOutlineWidth, kOutlineWidth,
+                           kOutlineWidth);
+  setVisible(false);
+}
+
+QRectF ContourItem::boundingRect() const { return m_bounds; }
+
+/**
+ * @brief Picks the level of detail whose error stays under half a screen
+ *        pixel at the painter's scale.
+ */
+void ContourItem::paint(QPainter *painter,
+                        const QStyleOptionGraphicsItem *option, QWidget *) {
+  qreal lod{option->levelOfDetailFromTransform(painter->worldTransform())};
+  int level{0};
+  if (lod < 1.0) {
+    level = std::min(kLevels - 1,
+                     1 + static_cast<int>(std::floor(std::log2(1.0 / lod))));
+  }
+  const QPolygonF &shape{polygon(level)};
+
+  // Same layering as the former overlays: saved contours are tinted,
+  // highlighted ones filled, and both outlined.
+  QColor fill{m_color};
+  if (m_highlighted) {
+    painter->setBrush(fill);
+  } else if (m_saved) {
+    fill.setAlpha(63);
+    painter->setBrush(fill);
+  } else {
+    painter->setBrush(Qt::NoBrush);
+  }
+  if ((m_outlined && m_listed) || m_saved) {
+    painter->setPen(QPen(m_color, kOutlineWidth));
+  } else {
+    painter->setPen(Qt::NoPen);
+  }
+  painter->drawPolygon(shape);
+}
+
+void ContourItem::setOutlined(bool outlined) {
+  if (m_outlined != outlined) {
+    m_outlined = outlined;
+    updateVisibility();
+  }
+}
+
+// Filtered out contours lose their outline; saved and selected ones stay
+// marked.
+void ContourItem::setListed(bool listed) {
+  if (m_listed != listed) {
+    m_listed = listed;
+    updateVisibility();
+  }
+}
+
+void ContourItem::setSaved(bool saved) {
+  if (m_saved != saved) {
+    m_saved = saved;
+    updateVisibility();
+  }
+}
+
+void ContourItem::setHighlighted(bool highlighted) {
+  if (m_highlighted != highlighted) {
+    m_highlighted = highlighted;
+    updateVisibility();
+  }
+}
+
+/**
+ * @brief Level 0 is the contour as found, level n a simplification with an
+ *        error of at most 2^(n - 2) pixels.
+ */
+const QPolygonF &ContourItem::polygon(int level) {
+  if (!m_level_ready[level]) {
+    if (level == 0) {
+      m_levels[level] = toPolygon(m_contour.data, m_contour.size);
+    } else {
+      PROFILE_SCOPE("simplify contour");
+      std::vector<cv::Point> simplified{};
+      cv::approxPolyDP(m_contour.mat(), simplified, std::ldexp(1.0, level - 2),
+                       true);
+      m_levels[level] = toPolygon(simplified.data(), simplified.size());
+    }
+    m_level_ready[level] = true;
+  }
+
+  return m_levels[level];
+}
+
+// Items with nothing to draw are hidden, which keeps them out of painting
+// and out of the scene's index lookups.
+void ContourItem::updateVisibility() {
+  setVisible((m_outlined && m_listed) || m_saved || m_highlighted);
+  update();
+}
+
+ContourViewer::ContourViewer(QWidget *parent) : QGraphicsView(parent) {
+  m_scene = new QGraphicsScene{this};
+  m_scene->setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+  setScene(m_scene);
+  m_image_item = new QGraphicsPixmapItem{};
+  m_scene->addItem(m_image_item);
+
+  setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+  setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
+  setOptimizationFlag(QGraphicsView::DontAdjustForAntialiasing);
+  setBackgroundBrush(palette().window());
+  setAlignment(Qt::AlignCenter);
+}
+
+ContourViewer::~ContourViewer() {}
+
+void ContourViewer::setImage(const QImage &image) {
+  m_image_item->setPixmap(QPixmap::fromImage(image));
+  m_scene->setSceneRect(m_image_item->boundingRect());
+  fitImage();
+}
+
+void ContourViewer::setContours(const ContourStore &contours) {
+  for (ContourItem *item : m_items) {
+    delete item;
+  }
+  m_items.clear();
+  m_saved.clear();
+  m_highlighted.clear();
+  // The items point into the store, which does not change until they are
+  // deleted.
+  m_contours = contours;
+
+  m_items.reserve(m_contours.size());
+  for (int i = 0; i != static_cast<int>(m_contours.size()); ++i) {
+    // Items added later are stacked on top, as contours drawn later were.
+    ContourItem *item =
+        new ContourItem{m_contours[i], m_contours.bbox(i), i};
+    item->setOutlined(m_outlines_visible);
+    m_scene->addItem(item);
+    m_items.push_back(item);
+  }
+}
+
+void ContourViewer::clear() {
+  setContours({});
+  m_image_item->setPixmap(QPixmap{});
+  m_scene->setSceneRect(QRectF{});
+  resetTransform();
+}
+
+/**
+ * @brief Zooms so that the whole image fits the view, never enlarging it.
+ */
+void ContourViewer::fitImage() {
+  QRectF image_rect{m_image_item->boundingRect()};
+  resetTransform();
+  if (image_rect.isEmpty()) {
+    return;
+  }
+
+  qreal zoom{std::min(
+      {1.0, viewport()->width() / image_rect.width(),
+       viewport()->height() / image_rect.height()})};
+  scale(zoom, zoom);
+  centerOn(image_rect.center());
+  emit visibleAreaChanged();
+}
+
+/**
+ * @brief Part of the image within the viewport, in image pixels.
+ */
+QRect ContourViewer::visibleImageRect() const {
+  return mapToScene(viewport()->rect())
+      .boundingRect()
+      .toAlignedRect()
+      .intersected(m_image_item->boundingRect().toAlignedRect());
+}
+
+void ContourViewer::setOutlinesVisible(bool visible) {
+  if (m_outlines_visible == visible) {
+    return;
+  }
+  m_outlines_visible = visible;
+  for (ContourItem *item : m_items) {
+    item->setOutlined(visible);
+  }
+}
+
+/**
+ * @brief Outlines only the given contours, as the filter leaves them. Only
+ *        the contours whose state changes are repainted.
+ */
+void ContourViewer::setListedContours(const std::vector<int> &numbers) {
+  std::vector<bool> listed(m_items.size(), false);
+  for (int number : numbers) {
+    if (number >= 0 && number < static_cast<int>(m_items.size())) {
+      listed[number] = true;
+    }
+  }
+  for (size_t i = 0; i != m_items.size(); ++i) {
+    m_items[i]->setListed(listed[i]);
+  }
+}
+
+/**
+ * @brief Marks the saved contours. Only the contours whose state changes are
+ *        repainted.
+ */
+void ContourViewer::setSavedContours(const std::vector<int> &numbers) {
+  for (int number : m_saved) {
+    m_items[number]->setSaved(false);
+  }
+  m_saved.clear();
+  for (int number : numbers) {
+    if (number >= 0 && number < static_cast<int>(m_items.size())) {
+      m_items[number]->setSaved(true);
+      m_saved.push_back(number);
+    }
+  }
+}
+
+/**
+ * @brief Marks the selected contours. Only the contours whose state changes
+ *        are repainted.
+ */
+void ContourViewer::setHighlightedContours(const std::vector<int> &numbers) {
+  for (int number : m_highlighted) {
+    m_items[number]->setHighlighted(false);
+  }
+  m_highlighted.clear();
+  for (int number : numbers) {
+    if (number >= 0 && number < static_cast<int>(m_items.size())) {
+      m_items[number]->setHighlighted(true);
+      m_highlighted.push_back(number);
+    }
+  }
+}
+
+void ContourViewer::wheelEvent(QWheelEvent *event) {
+  qreal factor{std::pow(1.25, event->angleDelta().y() / 120.0)};
+  qreal zoom{transform().m11() * factor};
+  if (zoom < kMinZoom || zoom > kMaxZoom) {
+    return;
+  }
+  scale(factor, factor);
+  emit visibleAreaChanged();
+}
+
+void ContourViewer::mousePressEvent(QMouseEvent *event) {
+  m_press_pos = event->pos();
+  m_panning = false;
+  if (event->button() == Qt::RightButton) {
+    emit rmbClicked(imagePos(event->pos()),
+                    event->globalPosition().toPoint());
+  }
+}
+
+void ContourViewer::mouseMoveEvent(QMouseEvent *event) {
+  if (!(event->buttons() & Qt::LeftButton)) {
+    return;
+  }
+
+  QPoint delta{event->pos() - m_press_pos};
+  if (!m_panning &&
+      delta.manhattanLength() < QApplication::startDragDistance()) {
+    return;
+  }
+  m_panning = true;
+  setCursor(Qt::ClosedHandCursor);
+  horizontalScrollBar()->setValue(horizontalScrollBar()->value() - delta.x());
+  verticalScrollBar()->setValue(verticalScrollBar()->value() - delta.y());
+  m_press_pos = event->pos();
+}
+
+void ContourViewer::mouseReleaseEvent(QMouseEvent *event) {
+  if (event->button() != Qt::LeftButton) {
+    return;
+  }
+
+  if (m_panning) {
+    m_panning = false;
+    unsetCursor();
+  } else {
+    emit lmbClicked(imagePos(event->pos()));
+  }
+}
+
+void ContourViewer::resizeEvent(QResizeEvent *event) {
+  QGraphicsView::resizeEvent(event);
+  emit visibleAreaChanged();
+}
+
+void ContourViewer::scrollContentsBy(int dx, int dy) {
+  QGraphicsView::scrollContentsBy(dx, dy);
+  emit visibleAreaChanged();
+}
+
+QPoint ContourViewer::imagePos(const QPoint &view_pos) const {
+  QPointF scene_pos{mapToScene(view_pos)};
+  return QPoint(static_cast<int>(std::floor(scene_pos.x())),
+                static_cast<int>(std::floor(scene_pos.y())));
+}
@@ -0,0 +1,55 @@
+#include <iostream>
+
+#include "contour_export.h"
+
+namespace {
+void printUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [--geojson FILE] [--csv FILE] <archive>\n";
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::string archive_path{};
+  std::string geojson_path{};
+  std::string csv_path{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if ((arg == "--geojson" || arg == "--csv") && i + 1 < argc) {
+      (arg == "--geojson" ? geojson_path : csv_path) = argv[++i];
+    } else if (arg == "-h" || arg == "--help") {
+      printUsage(argv[0]);
+      return 0;
+    } else if (!arg.empty() && arg[0] == '-') {
+      printUsage(argv[0]);
+      return 1;
+    } else {
+      archive_path = arg;
+    }
+  }
+  if (archive_path.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  ContourArchive archive{};
+  if (!archive.open(archive_path)) {
+    std::cerr << "Cannot read archive " << archive_path << "\n";
+    return 2;
+  }
+  std::cout << archive.imageCount() << " images, " << archive.contourCount()
+            << " contours\n";
+
+  int status{0};
+  if (!geojson_path.empty() && !exportGeoJson(archive, geojson_path)) {
+    std::cerr << "Cannot export " << geojson_path << "\n";
+    status = 2;
+  }
+  if (!csv_path.empty() && !exportCsv(archive, csv_path)) {
+    std::cerr << "Cannot export " << csv_path << "\n";
+    status = 2;
+  }
+
+  return status;
+}
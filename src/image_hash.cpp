@@ -0,0 +1,38 @@
+#include "image_hash.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+
+/**
+ * @brief Content hash identifying an image independently of its file name.
+ *
+ * @param data Encoded image file contents.
+ * @return Hex encoded SHA-256 of the data.
+ */
+std::string hashImageData(const QByteArray &data) {
+  return QCryptographicHash::hash(data, QCryptographicHash::Sha256)
+      .toHex()
+      .toStdString();
+}
+
+/**
+ * @brief Same as hashImageData, reading the file first.
+ *
+ * @param file_path Image file.
+ * @return Hex encoded SHA-256 of the file, or an empty string if it cannot be
+ *         read.
+ */
+std::string hashImageFile(const std::string &file_path) {
+  QFile file{QString::fromStdString(file_path)};
+  if (!file.open(QIODevice::ReadOnly)) {
+    return {};
+  }
+
+  // Hashed as it is read, so that large files are never in memory whole.
+  QCryptographicHash hash{QCryptographicHash::Sha256};
+  if (!hash.addData(&file)) {
+    return {};
+  }
+
+  return hash.result().toHex().toStdString();
+}
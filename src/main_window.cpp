@@ -1,12 +1,24 @@
 #include "main_window.h"
 #include "contour_detection.h"
+#include "contour_codec.h"
+#include "image_hash.h"
+#include "profiler.h"
+#include "pyramid_detection.h"
 #include "sql_query_handler.h"
+#include "tiled_detection.h"
 
 MainWindow::MainWindow() {
   setWindowTitle("Contours");
   setMinimumSize(800, 600);
 
   establishDbConnection();
+  m_contour_cache = std::make_unique<ContourCache>(
+      (QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+       "/contours")
+          .toStdString());
+  m_image_load_watcher = new QFutureWatcher<ImageLoadResult>{this};
+  m_saved_contours_watcher = new QFutureWatcher<SavedContoursResult>{this};
+  m_save_watcher = new QFutureWatcher<SaveResult>{this};
   createWidgets();
   createTables();
   createActions();
@@ -16,16 +28,23 @@ MainWindow::MainWindow() {
   connect(show_contours_button, &QPushButton::clicked, this,
           displayAllContours);
   connect(save_contours_button, &QPushButton::clicked, this, saveContours);
+  connect(filter_panel, &ContourFilterPanel::filterChanged, this,
+          applyContourFilter);
+  connect(contour_viewer, &ContourViewer::visibleAreaChanged, this, [this]() {
+    if (filter_panel->limitedToView()) {
+      applyContourFilter();
+    }
+  });
 
-  connect(found_contour_label, SIGNAL(lmbClicked(const QPoint &)), this,
+  connect(contour_viewer, SIGNAL(lmbClicked(const QPoint &)), this,
           SLOT(selectClickedContours(const QPoint &)));
-  connect(found_contour_label, SIGNAL(rmbClicked(const QPoint &)), this,
-          SLOT(showAddContextMenuLabel(const QPoint &)));
+  connect(contour_viewer, SIGNAL(rmbClicked(const QPoint &, const QPoint &)),
+          this, SLOT(showAddContextMenuViewer(const QPoint &, const QPoint &)));
 
-  connect(found_contours_table, &QTableWidget::itemSelectionChanged, this,
-          displayAllContours);
-  connect(saved_contours_table, &QTableWidget::itemSelectionChanged, this,
-          displaySavedContours);
+  connect(found_contours_table->selectionModel(),
+          &QItemSelectionModel::selectionChanged, this, displayAllContours);
+  connect(saved_contours_table->selectionModel(),
+          &QItemSelectionModel::selectionChanged, this, displaySavedContours);
 
   connect(found_contours_table,
           SIGNAL(customContextMenuRequested(const QPoint &)), this,
@@ -34,8 +53,32 @@ MainWindow::MainWindow() {
           SIGNAL(customContextMenuRequested(const QPoint &)), this,
           SLOT(showDeleteContextMenu(const QPoint &)));
 
-  connect(saved_contours_table, &QTableWidget::itemChanged, this,
-          [this]() { m_table_has_changed = true; });
+  connect(m_saved_model, &QAbstractItemModel::dataChanged, this, [this]() {
+    m_table_has_changed = true;
+    ++m_table_revision;
+  });
+
+  connect(m_image_load_watcher, &QFutureWatcher<ImageLoadResult>::resultReadyAt,
+          this, &MainWindow::handleImageLoadResult);
+  connect(m_image_load_watcher, &QFutureWatcherBase::finished, this, [this]() {
+    if (!m_image_load_watcher->isCanceled() &&
+        m_image_load_watcher->future().resultCount() == 0) {
+      QMessageBox::warning(this, "Open Image", "The image cannot be read.");
+      m_image_path.clear();
+    }
+  });
+  connect(m_saved_contours_watcher, &QFutureWatcherBase::finished, this,
+          &MainWindow::handleSavedContoursLoaded);
+  connect(m_save_watcher, &QFutureWatcherBase::finished, this,
+          &MainWindow::handleContoursSaved);
+}
+
+MainWindow::~MainWindow() {
+  // Workers use the database connection, which is owned by the window.
+  cancelImageLoad();
+  m_image_load_watcher->waitForFinished();
+  m_saved_contours_watcher->waitForFinished();
+  m_save_watcher->waitForFinished();
 }
 
 void MainWindow::openImage() {
@@ -56,43 +99,9 @@ void MainWindow::openImage() {
     if (dialog.exec() == QDialog::Accepted &&
         m_image_path != dialog.selectedFiles().first()) {
       m_image_path = dialog.selectedFiles().first();
-      QPixmap image{m_image_path};
       m_image_name = QFileInfo(m_image_path).fileName();
-
-      // Resize image if it's too tall
-      if (image.height() > 800) {
-        image = image.scaled(image.width(), 800, Qt::KeepAspectRatio);
-      }
-
-      m_image_height = image.height();
-      m_image_width = image.width();
-      m_found_contours = getContourVector(fromQPixmapToCvMat(image));
-
-      image_label->setFixedHeight(m_image_height);
-      image_label->setFixedWidth(m_image_width);
-      image_label->setPixmap(image);
-      image_label->show();
-
-      saved_contour_label->setFixedHeight(m_image_height);
-      saved_contour_label->setFixedWidth(m_image_width);
-
-      found_contour_label->setFixedHeight(m_image_height);
-      found_contour_label->setFixedWidth(m_image_width);
-
-      highlight_label->setFixedHeight(m_image_height);
-      highlight_label->setFixedWidth(m_image_width);
-
-      m_saved_contours.clear();
-      found_contours_table->setRowCount(0);
-      fillFoundContoursTable();
-      saved_contours_table->setRowCount(0);
-      fillContoursToAddTable();
-      saved_contour_label->clear();
-      displaySavedContours();
-      found_contour_label->clear();
-      highlight_label->clear();
-      displayAllContours();
-      m_table_has_changed = false;
+      m_canonical_path = QFileInfo(m_image_path).canonicalFilePath();
+      startImageLoad();
     }
   }
 }
@@ -100,12 +109,15 @@ void MainWindow::openImage() {
 void MainWindow::exitApp() { this->close(); }
 
 void MainWindow::selectClickedContours(const QPoint &click_pos) {
-  if (clickedContourNumber(m_found_contours, click_pos.x(), click_pos.y()) ==
-      -1) {
+  int contour_number{
+      clickedContourNumber(m_contour_label_map, click_pos.x(), click_pos.y())};
+  // Contours filtered out of the table cannot be selected.
+  int row{m_found_model->contourRow(contour_number)};
+  if (row == -1) {
     found_contours_table->clearSelection();
   } else {
-    found_contours_table->selectRow(
-        clickedContourNumber(m_found_contours, click_pos.x(), click_pos.y()));
+    found_contours_table->selectRow(row);
+    found_contours_table->scrollTo(m_found_model->index(row, 0));
   }
 }
 
@@ -116,10 +128,11 @@ void MainWindow::showAddContextMenuTable(const QPoint &click_pos) {
   }
 }
 
-void MainWindow::showAddContextMenuLabel(const QPoint &click_pos) {
-  if (clickedContourNumber(m_found_contours, click_pos.x(), click_pos.y()) !=
-      -1) {
-    add_context_menu->popup(image_label->mapToGlobal(click_pos));
+void MainWindow::showAddContextMenuViewer(const QPoint &image_pos,
+                                          const QPoint &global_pos) {
+  if (m_found_model->contourRow(clickedContourNumber(
+          m_contour_label_map, image_pos.x(), image_pos.y())) != -1) {
+    add_context_menu->popup(global_pos);
   }
 }
 
@@ -147,52 +160,282 @@ void MainWindow::closeEvent(QCloseEvent *event) {
 
 void MainWindow::establishDbConnection() {
   // Use your database credentials
-  m_conn = std::make_unique<pqxx::connection>(
+  m_db_pool = std::make_unique<ConnectionPool>(
       "dbname = ... user = ... password = ... hostaddr = ... port = ...");
+  // The window shows up without waiting for the database.
+  m_db_pool->connectInBackground();
+}
+
+/**
+ * @brief Starts decoding the image, detecting its contours and fetching its
+ *        saved contours in the background. Results are shown as they arrive;
+ *        a load still in flight is cancelled.
+ */
+void MainWindow::startImageLoad() {
+  cancelImageLoad();
+
+  m_image_hash.clear();
+  m_found_contours.clear();
+  m_contour_label_map.release();
+  m_saved_contours.clear();
+  m_contours_ready = false;
+  m_saved_contours_ready = false;
+  m_found_model->setContourNumbers({});
+  m_saved_model->setContours({});
+  contour_viewer->clear();
+  updateSaveButton();
+  m_table_has_changed = false;
+
+  m_image_load_watcher->setFuture(QtConcurrent::run(
+      [this](QPromise<ImageLoadResult> &promise, const QString &image_path,
+             int max_height) { loadImage(promise, image_path, max_height); },
+      m_image_path, full_resolution_action->isChecked() ? 0 : 800));
+
+  fetchSavedContours();
+}
+
+/**
+ * @brief Fetches the image's saved contours in the background. Saving stays
+ *        disabled until a fetch succeeds, as it would overwrite the contours
+ *        that could not be fetched.
+ */
+void MainWindow::fetchSavedContours() {
+  m_saved_contours_watcher->setFuture(
+      QtConcurrent::run([this, image_path = m_canonical_path.toStdString(),
+                         image_name = m_image_name.toStdString()]() {
+        PROFILE_SCOPE("db fetch saved contours");
+        SavedContoursResult result{};
+        try {
+          ConnectionPool::Lease conn{m_db_pool->acquire()};
+          result.contours = getContoursFromDb(*conn, image_path, image_name);
+          result.loaded = true;
+        } catch (const std::exception &e) {
+          result.error = e.what();
+        }
+        return result;
+      }));
+}
+
+/**
+ * @brief Worker side of startImageLoad. Runs outside of the GUI thread and
+ *        reports the decoded image, then the image's contours.
+ *
+ * @param promise Receives the results, tells whether the load is cancelled;
+ * @param image_path Image to load;
+ * @param max_height Taller images are scaled down to it, 0 keeps them as is.
+ */
+void MainWindow::loadImage(QPromise<ImageLoadResult> &promise,
+                           const QString &image_path, int max_height) {
+  PROFILE_SCOPE("load image");
+  QFile file{image_path};
+  if (!file.open(QIODevice::ReadOnly)) {
+    return;
+  }
+  // The file is read once, for both its hash and decoding.
+  QByteArray data{};
+  {
+    PROFILE_SCOPE("read file");
+    data = file.readAll();
+  }
+  QImage image{};
+  {
+    PROFILE_SCOPE("decode image");
+    // QImage, unlike QPixmap, can be used outside of the GUI thread.
+    image = QImage::fromData(data);
+    if (image.isNull() || promise.isCanceled()) {
+      return;
+    }
+    // Resize image if it's too tall
+    if (max_height > 0 && image.height() > max_height) {
+      image = image.scaled(image.width(), max_height, Qt::KeepAspectRatio);
+    }
+    // Detection reads the decoded pixels in place, the only conversion left
+    // is to the RGB layout it expects.
+    image.convertTo(QImage::Format_RGB888);
+  }
+
+  ImageLoadResult decoded{};
+  decoded.stage = ImageLoadResult::Decoded;
+  decoded.image = image;
+  {
+    PROFILE_SCOPE("hash image");
+    decoded.image_hash = hashImageData(data);
+  }
+  promise.addResult(decoded);
+  if (promise.isCanceled()) {
+    return;
+  }
+
+  ImageLoadResult detected{};
+  detected.stage = ImageLoadResult::Detected;
+  // Contours stored in the database for a known image come first, so the
+  // saved contour numbers keep matching even if detection has changed since
+  // or the contours were saved from another machine. The local cache answers
+  // when the database has none or cannot be reached.
+  std::string cache_key{ContourCache::makeKey(
+      decoded.image_hash, contourDetectorParameters() + ";scaler=qt",
+      image.height(), image.width())};
+  detected.from_store = loadStoredGeometry(
+      decoded.image_hash, image.height(), image.width(), detected.contours);
+  if (detected.from_store) {
+    // Replaces a local detection that may number the contours differently.
+    m_contour_cache->put(cache_key, detected.contours);
+  } else {
+    {
+      PROFILE_SCOPE("cache lookup");
+      detected.from_store = m_contour_cache->get(cache_key, detected.contours);
+    }
+    if (!detected.from_store) {
+      {
+        PROFILE_SCOPE("detect contours");
+        // At full resolution objects are usually sparse enough for the
+        // coarse level to rule out most of the image.
+        detected.contours =
+            max_height > 0 ? getContourVectorBanded(wrapQImageAsCvMat(image))
+                           : getContourVectorPyramid(wrapQImageAsCvMat(image));
+      }
+      m_contour_cache->put(cache_key, detected.contours);
+    }
+  }
+  PROFILE_COUNTER("contours found", detected.contours.size());
+  if (promise.isCanceled()) {
+    return;
+  }
+  {
+    PROFILE_SCOPE("build label map");
+    detected.contour_label_map =
+        buildContourLabelMap(detected.contours, image.height(), image.width());
+  }
+  promise.addResult(std::move(detected));
+}
+
+bool MainWindow::loadStoredGeometry(
+    const std::string &image_hash, int img_height, int img_width,
+    ContourStore &contours) {
+  PROFILE_SCOPE("db geometry lookup");
+  std::vector<uint8_t> geometry{};
+  try {
+    ConnectionPool::Lease conn{m_db_pool->acquire()};
+    if (!getContourGeometryFromDb(*conn, image_hash, img_height, img_width,
+                                  geometry)) {
+      return false;
+    }
+  } catch (...) {
+    return false;
+  }
+
+  return decodeContours(geometry.data(), geometry.size(), contours);
+}
+
+/**
+ * @brief Stops the image load in flight. Its remaining results are dropped
+ *        once the watchers are given a new future.
+ */
+void MainWindow::cancelImageLoad() {
+  m_image_load_watcher->cancel();
+}
+
+void MainWindow::handleImageLoadResult(int index) {
+  ImageLoadResult result{m_image_load_watcher->resultAt(index)};
+
+  if (result.stage == ImageLoadResult::Decoded) {
+    m_image_hash = result.image_hash;
+    m_image_height = result.image.height();
+    m_image_width = result.image.width();
+    contour_viewer->setImage(result.image);
+  } else {
+    m_found_contours = std::move(result.contours);
+    m_contour_label_map = result.contour_label_map;
+    m_contours_ready = true;
+
+    {
+      PROFILE_SCOPE("build contour items");
+      // Contours are vector items drawn at the current zoom, so nothing is
+      // rendered up front whatever the image size.
+      contour_viewer->setContours(m_found_contours);
+    }
+
+    fillFoundContoursTable();
+    displayAllContours();
+    if (m_saved_contours_ready) {
+      displaySavedContours();
+    }
+    updateSaveButton();
+  }
+}
+
+/**
+ * @brief Saving is possible once both the found and the saved contours have
+ *        arrived and no other save is in flight. Before that it would write
+ *        the saved contours without their geometry, or overwrite them.
+ */
+void MainWindow::updateSaveButton() {
+  save_contours_button->setEnabled(m_contours_ready && m_saved_contours_ready &&
+                                   !m_save_watcher->isRunning());
+}
+
+void MainWindow::handleSavedContoursLoaded() {
+  if (m_saved_contours_watcher->isCanceled() ||
+      m_saved_contours_watcher->future().resultCount() == 0) {
+    return;
+  }
+
+  SavedContoursResult result{m_saved_contours_watcher->result()};
+  if (!result.loaded) {
+    int ret{QMessageBox::warning(
+        this, "Database Unavailable",
+        QString{"The saved contours could not be loaded, saving is disabled "
+                "until they are: "} +
+            QString::fromStdString(result.error),
+        QMessageBox::Retry | QMessageBox::Cancel)};
+    if (ret == QMessageBox::Retry) {
+      fetchSavedContours();
+    }
+    return;
+  }
+
+  fillContoursToAddTable(result.contours);
+  m_saved_contours_ready = true;
+  updateSaveButton();
+  if (m_contours_ready) {
+    displaySavedContours();
+  }
 }
 
 void MainWindow::createWidgets() {
   central_widget = new QWidget{this};
   setCentralWidget(central_widget);
 
-  stacked_labels = new QStackedWidget{this};
-  image_label = new QLabel{this};
-  saved_contour_label = new QLabel{this};
-  found_contour_label = new ClickableLabel{this};
-  highlight_label = new QLabel{this};
-  stacked_labels->addWidget(found_contour_label);
-  stacked_labels->addWidget(highlight_label);
-  stacked_labels->addWidget(saved_contour_label);
-  stacked_labels->addWidget(image_label);
-  image_label->setAlignment(Qt::AlignCenter);
+  contour_viewer = new ContourViewer{this};
 
   show_contours_button = new QPushButton{"Show Contours", this};
   show_contours_button->setCheckable(true);
   save_contours_button = new QPushButton{"Save Changes", this};
+  filter_panel = new ContourFilterPanel{this};
 }
 
 void MainWindow::createTables() {
-  found_contours_table = new QTableWidget{this};
-  found_contours_table->setColumnCount(1);
+  // The tables are views over models computing rows on demand, so filling
+  // them does not depend on the number of contours.
+  m_found_model = new FoundContoursModel{this};
+  found_contours_table = new QTableView{this};
+  found_contours_table->setModel(m_found_model);
   found_contours_table->verticalHeader()->setSectionResizeMode(
       QHeaderView::Fixed);
   found_contours_table->horizontalHeader()->setStretchLastSection(true);
   found_contours_table->horizontalHeader()->setSectionResizeMode(
       QHeaderView::Fixed);
-  QList<QString> found_contours_table_headers{"All Found Contours"};
-  found_contours_table->setHorizontalHeaderLabels(found_contours_table_headers);
   found_contours_table->setContextMenuPolicy(Qt::CustomContextMenu);
   found_contours_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
 
-  saved_contours_table = new QTableWidget{this};
-  saved_contours_table->setColumnCount(1);
+  m_saved_model = new SavedContoursModel{this};
+  saved_contours_table = new QTableView{this};
+  saved_contours_table->setModel(m_saved_model);
   saved_contours_table->verticalHeader()->setSectionResizeMode(
       QHeaderView::Fixed);
   saved_contours_table->horizontalHeader()->setStretchLastSection(true);
   saved_contours_table->horizontalHeader()->setSectionResizeMode(
       QHeaderView::Fixed);
-  QList<QString> saved_contours_table_headers{"Saved Contours"};
-  saved_contours_table->setHorizontalHeaderLabels(saved_contours_table_headers);
   saved_contours_table->setContextMenuPolicy(Qt::CustomContextMenu);
 }
 
@@ -212,6 +455,26 @@ void MainWindow::createActions() {
   delete_action = new QAction{QIcon::fromTheme(QIcon::ThemeIcon::EditDelete),
                               "Delete", this};
   connect(delete_action, &QAction::triggered, this, deleteContours);
+
+  stats_action = new QAction{"Timing Statistics", this};
+  connect(stats_action, &QAction::triggered, this, showStatsPanel);
+
+  // Applies to the next image opened. Saved contour numbers refer to the
+  // contours found at the resolution the image was saved at; the geometry
+  // of each resolution is stored separately.
+  full_resolution_action = new QAction{"Load at Full Resolution", this};
+  full_resolution_action->setCheckable(true);
+}
+
+/**
+ * @brief Shows the window with the timing statistics, created on first use.
+ */
+void MainWindow::showStatsPanel() {
+  if (stats_panel == nullptr) {
+    stats_panel = new StatsPanel{this};
+  }
+  stats_panel->show();
+  stats_panel->raise();
 }
 
 void MainWindow::createMenus() {
@@ -219,6 +482,11 @@ void MainWindow::createMenus() {
   QList action_list{open_action, exit_action};
   file_menu->addActions(action_list);
 
+  view_menu = menuBar()->addMenu("View");
+  view_menu->addAction(full_resolution_action);
+  view_menu->addSeparator();
+  view_menu->addAction(stats_action);
+
   add_context_menu = new QMenu{this};
   add_context_menu->addAction(add_action);
 
@@ -229,12 +497,13 @@ void MainWindow::createMenus() {
 void MainWindow::createLayout() {
   QVBoxLayout *v_main_layout = new QVBoxLayout{};
   v_main_layout->addSpacing(10);
-  v_main_layout->addWidget(stacked_labels, 0, Qt::AlignCenter);
-  stacked_labels->setMinimumHeight(this->height() / 2);
+  v_main_layout->addWidget(contour_viewer, 1);
+  contour_viewer->setMinimumHeight(this->height() / 2);
   QHBoxLayout *h_tables_layout = new QHBoxLayout{};
   h_tables_layout->addSpacing(50);
   QVBoxLayout *v_found_contours_table_layout = new QVBoxLayout{};
   v_found_contours_table_layout->addWidget(show_contours_button);
+  v_found_contours_table_layout->addWidget(filter_panel);
   v_found_contours_table_layout->addWidget(found_contours_table);
   h_tables_layout->addLayout(v_found_contours_table_layout);
   h_tables_layout->addSpacing(50);
@@ -261,73 +530,88 @@ int MainWindow::createPopup(const QString &window_title, const QString &text,
   return message_box.exec();
 }
 
-void MainWindow::fillFoundContoursTable() {
-  found_contours_table->setRowCount(0);
-  for (const auto &vect : m_found_contours) {
-    found_contours_table->insertRow(found_contours_table->rowCount());
-    QTableWidgetItem *new_item = new QTableWidgetItem(
-        tr("Contour №%1").arg(found_contours_table->rowCount()));
-    // Item data stores its contour number,
-    // in this case it equals to (item's row - 1).
-    new_item->setData(Qt::UserRole, found_contours_table->rowCount() - 1);
-    new_item->setBackground(
-        hueToRgbaQColor(80 * (new_item->data(Qt::UserRole).toInt()) % 360, 63));
-    found_contours_table->setItem(found_contours_table->rowCount() - 1, 0,
-                                  new_item);
+void MainWindow::fillFoundContoursTable() { applyContourFilter(); }
+
+/**
+ * @brief Lists the found contours passing the filter panel's bounds, in its
+ *        order, and outlines only those. Works from the features computed at
+ *        detection; the selection is kept for the contours still listed.
+ */
+void MainWindow::applyContourFilter() {
+  if (!m_contours_ready) {
+    return;
+  }
+
+  ContourFilter filter{filter_panel->filter()};
+  if (filter_panel->limitedToView()) {
+    QRect view_rect{contour_viewer->visibleImageRect()};
+    filter.region =
+        cv::Rect(view_rect.x(), view_rect.y(), view_rect.width(),
+                 view_rect.height());
+  }
+  std::vector<int> numbers{
+      filterContours(m_found_contours, filter, filter_panel->order())};
+  // Panning with the view filter on mostly leaves the list as it is. A new
+  // image starts from an empty list, so an empty result is always applied.
+  if (numbers == m_found_model->listedContours() && !numbers.empty()) {
+    return;
   }
+
+  std::vector<int> selected{getSelectedContourNum(*found_contours_table)};
+  contour_viewer->setListedContours(numbers);
+  m_found_model->setContourNumbers(std::move(numbers));
+
+  QItemSelection selection{};
+  for (int number : selected) {
+    int row{m_found_model->contourRow(number)};
+    if (row != -1) {
+      selection.select(m_found_model->index(row, 0),
+                       m_found_model->index(row, 0));
+    }
+  }
+  found_contours_table->selectionModel()->select(
+      selection, QItemSelectionModel::ClearAndSelect);
+  displayAllContours();
 }
 
-void MainWindow::fillContoursToAddTable() {
-  saved_contours_table->setRowCount(0);
-  std::vector<std::pair<int, std::string>> saved_contours{
-      getContoursFromDb(*m_conn, m_image_name.toStdString())};
+void MainWindow::fillContoursToAddTable(
+    const std::vector<std::pair<int, std::string>> &saved_contours) {
+  PROFILE_SCOPE("fill saved contours table");
+  m_saved_model->setContours(saved_contours);
   for (const auto &pair : saved_contours) {
-    saved_contours_table->insertRow(saved_contours_table->rowCount());
-    QTableWidgetItem *new_item =
-        new QTableWidgetItem{QString::fromStdString(pair.second)};
-    // Item data stores its contour number,
-    new_item->setData(Qt::UserRole, pair.first);
-    new_item->setBackground(
-        hueToRgbaQColor(80 * (new_item->data(Qt::UserRole).toInt()) % 360, 63));
-    saved_contours_table->setItem(saved_contours_table->rowCount() - 1, 0,
-                                  new_item);
     m_saved_contours.insert({pair.first, pair.second});
   }
 }
 
 void MainWindow::displayAllContours() {
-  if (!m_image_path.isEmpty()) {
-    if (show_contours_button->isChecked()) {
-      found_contour_label->setPixmap(fromCvMatToQPixmap(
-          drawAllContours(m_found_contours, m_image_height, m_image_width)));
-      found_contour_label->show();
-      highlight_label->setPixmap(fromCvMatToQPixmap(
-          drawHighlights(m_found_contours, m_image_height, m_image_width,
-                         getSelectedContourNum(*found_contours_table))));
-      highlight_label->show();
-    } else {
-      found_contour_label->hide();
-      highlight_label->hide();
-    }
+  if (m_contours_ready) {
+    PROFILE_SCOPE("update contour items");
+    bool checked{show_contours_button->isChecked()};
+    contour_viewer->setOutlinesVisible(checked);
+    contour_viewer->setHighlightedContours(
+        checked ? getSelectedContourNum(*found_contours_table)
+                : std::vector<int>{});
   }
 }
 
 void MainWindow::displaySavedContours() {
+  if (!m_contours_ready) {
+    return;
+  }
+
   // Extracting the numbers of saved contours.
   std::vector<int> saved_contours_num;
   for (const auto &elem : m_saved_contours) {
     saved_contours_num.push_back(elem.first);
   }
-  saved_contour_label->setPixmap(fromCvMatToQPixmap(drawSavedContours(
-      m_found_contours, m_image_height, m_image_width, saved_contours_num)));
-  saved_contour_label->show();
-  highlight_label->setPixmap(fromCvMatToQPixmap(
-      drawHighlights(m_found_contours, m_image_height, m_image_width,
-                     getSelectedContourNum(*saved_contours_table))));
-  highlight_label->show();
+  PROFILE_SCOPE("update contour items");
+  contour_viewer->setSavedContours(saved_contours_num);
+  contour_viewer->setHighlightedContours(
+      getSelectedContourNum(*saved_contours_table));
 }
 
 void MainWindow::addContours() {
+  std::vector<std::pair<int, std::string>> added{};
   for (int row : getSelectedContourNum(*found_contours_table)) {
     // Using std::unordered_map to store added contours prevents user from
     // adding contours that have already been added.
@@ -336,15 +620,17 @@ void MainWindow::addContours() {
       // Contour names in m_saved_contours are not entered until the user
       // commits the changes via saveContours method.
       m_saved_contours.insert({row, ""});
-      saved_contours_table->insertRow(saved_contours_table->rowCount());
-      QTableWidgetItem *new_item =
-          new QTableWidgetItem{*(found_contours_table->item(row, 0))};
-      saved_contours_table->setItem(saved_contours_table->rowCount() - 1, 0,
-                                    new_item);
-      displaySavedContours();
-      m_table_has_changed = true;
+      // New contours are named after their row in the found contours table.
+      added.emplace_back(
+          row, FoundContoursModel::contourLabel(row).toStdString());
     }
   }
+  if (!added.empty()) {
+    m_saved_model->appendContours(added);
+    displaySavedContours();
+    m_table_has_changed = true;
+    ++m_table_revision;
+  }
   found_contours_table->clearSelection();
 }
 
@@ -353,41 +639,113 @@ void MainWindow::deleteContours() {
                         "Are you sure you want to delete these contours?",
                         QMessageBox::Question);
   if (ret == QMessageBox::Yes) {
-    QList<QTableWidgetItem *> selected_items =
-        saved_contours_table->selectedItems();
-    for (const QTableWidgetItem *item : selected_items) {
-      m_saved_contours.erase(item->data(Qt::UserRole).toInt());
-      saved_contours_table->removeRow(item->row());
+    QItemSelection selection{
+        saved_contours_table->selectionModel()->selection()};
+    for (int number : m_saved_model->contourNumbers(selection)) {
+      m_saved_contours.erase(number);
     }
+    m_saved_model->removeContours(selection);
     displaySavedContours();
     m_table_has_changed = true;
+    ++m_table_revision;
   }
 }
 
 void MainWindow::saveContours() {
-  if (!m_image_path.isEmpty()) {
+  if (!m_image_path.isEmpty() && m_contours_ready && m_saved_contours_ready) {
     int ret = createPopup("Save Changes?",
                           "Are you sure you want to save these changes?",
                           QMessageBox::Question);
     if (ret == QMessageBox::Yes) {
-      for (int row = 0; row < saved_contours_table->rowCount(); ++row) {
-        QTableWidgetItem *item = saved_contours_table->item(row, 0);
-        m_saved_contours[item->data(Qt::UserRole).toInt()] =
-            item->text().toStdString();
+      for (const auto &[number, name] : m_saved_model->contours()) {
+        m_saved_contours[number] = name;
       }
-      addContoursToDb(*m_conn, m_image_name.toStdString(), m_saved_contours);
-      m_table_has_changed = false;
+      m_saving_image_path = m_image_path;
+      m_saving_revision = m_table_revision;
+      // Waiting for a connection and the round trips would freeze the
+      // window, so the save runs in the background on copies of the data.
+      save_contours_button->setEnabled(false);
+      m_save_watcher->setFuture(QtConcurrent::run(
+          [this, image_path = m_canonical_path.toStdString(),
+           image_name = m_image_name.toStdString(),
+           saved_contours = m_saved_contours, image_hash = m_image_hash,
+           img_height = m_image_height, img_width = m_image_width,
+           contours = m_found_contours]() {
+            PROFILE_SCOPE("db save contours");
+            SaveResult result{};
+            // Without the found contours the saved numbers would lose their
+            // rows and the stored geometry would be replaced by none.
+            if (contours.empty() && !saved_contours.empty()) {
+              result.status = SaveResult::Failed;
+              result.error = "the image's contours are not available";
+              return result;
+            }
+            try {
+              // Geometry for the normalized contour table, computed at
+              // detection.
+              std::vector<ContourSummary> summaries{};
+              summaries.reserve(contours.size());
+              for (size_t i = 0; i != contours.size(); ++i) {
+                const cv::Rect &bbox{contours.bbox(i)};
+                summaries.push_back({bbox.x, bbox.y, bbox.width, bbox.height,
+                                     contours.area(i)});
+              }
+              ConnectionPool::Lease conn{m_db_pool->acquire()};
+              // Saved numbers refer to the stored geometry, so both are
+              // written in one transaction and neither is kept without the
+              // other.
+              pqxx::work work{*conn};
+              writeContours(work, image_path, image_name, saved_contours,
+                            summaries);
+              if (!image_hash.empty()) {
+                writeContourGeometry(work, image_hash, image_name, img_height,
+                                     img_width,
+                                     static_cast<int>(contours.size()),
+                                     encodeContours(contours));
+              }
+              work.commit();
+            } catch (const pqxx::broken_connection &) {
+              result.status = SaveResult::Unavailable;
+            } catch (const std::exception &e) {
+              // The transaction has been rolled back as a whole.
+              result.status = SaveResult::Failed;
+              result.error = e.what();
+            }
+            return result;
+          }));
     }
   }
 }
 
-std::vector<int> MainWindow::getSelectedContourNum(const QTableWidget &table) {
-  std::vector<int> selected_rows{};
-  QList<QTableWidgetItem *> selected_items = table.selectedItems();
+void MainWindow::handleContoursSaved() {
+  updateSaveButton();
+  SaveResult result{m_save_watcher->result()};
 
-  for (const QTableWidgetItem *item : selected_items) {
-    selected_rows.push_back(item->data(Qt::UserRole).toInt());
+  // The changes stay unsaved and can be saved again later.
+  if (result.status == SaveResult::Unavailable) {
+    QMessageBox::warning(this, "Database Unavailable",
+                         "Could not connect to the database.");
+    return;
   }
+  if (result.status == SaveResult::Failed) {
+    QMessageBox::warning(
+        this, "Save Failed",
+        QString{"The changes could not be saved: "} +
+            QString::fromStdString(result.error));
+    return;
+  }
+
+  // Changes made while saving, or another image opened since, are not
+  // covered by this save.
+  if (m_image_path == m_saving_image_path &&
+      m_table_revision == m_saving_revision) {
+    m_table_has_changed = false;
+  }
+}
+
+std::vector<int> MainWindow::getSelectedContourNum(const QTableView &table) {
+  const ContourListModel *model{
+      static_cast<const ContourListModel *>(table.model())};
 
-  return selected_rows;
+  return model->contourNumbers(table.selectionModel()->selection());
 }
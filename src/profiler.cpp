@@ -0,0 +1,279 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+
+namespace {
+// Trace timestamps count from the library's load, so that scopes begun
+// before the profiler's first use are not negative.
+const std::chrono::steady_clock::time_point g_origin{
+    std::chrono::steady_clock::now()};
+
+// Small, stable thread numbers read better in a trace than native ids.
+uint32_t currentThreadNumber() {
+  static std::atomic<uint32_t> next_number{1};
+  thread_local uint32_t number{next_number++};
+  return number;
+}
+
+int64_t microseconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(duration)
+      .count();
+}
+
+void writeJsonString(std::ofstream &out, const char *text) {
+  out << '"';
+  for (const char *c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      out << '\\';
+    }
+    out << *c;
+  }
+  out << '"';
+}
+} // namespace
+
+Profiler::Profiler() {}
+
+Profiler &Profiler::instance() {
+  static Profiler profiler{};
+  return profiler;
+}
+
+void Profiler::recordScope(const char *name, Clock::time_point start,
+                           Clock::time_point end) {
+  double ms{std::chrono::duration<double, std::milli>(end - start).count()};
+  TraceEvent event{name, currentThreadNumber(), microseconds(start - g_origin),
+                   microseconds(end - start), 0};
+
+  ThreadBuffer &buffer{threadBuffer()};
+  std::lock_guard<std::mutex> lock{buffer.mutex};
+  StageTotals &stats{buffer.stages[name]};
+  ++stats.count;
+  stats.last_ms = ms;
+  stats.total_ms += ms;
+  stats.max_ms = std::max(stats.max_ms, ms);
+  stats.last_us = event.start_us + event.duration_us;
+  addEvent(buffer, event, kMaxThreadEvents);
+}
+
+void Profiler::recordCounter(const char *name, int64_t value) {
+  TraceEvent event{name, currentThreadNumber(),
+                   microseconds(Clock::now() - g_origin), -1, value};
+
+  ThreadBuffer &buffer{threadBuffer()};
+  std::lock_guard<std::mutex> lock{buffer.mutex};
+  CounterTotals &stats{buffer.counters[name]};
+  ++stats.count;
+  stats.last = value;
+  stats.total += value;
+  stats.last_us = event.start_us;
+  addEvent(buffer, event, kMaxThreadEvents);
+}
+
+/**
+ * @brief Snapshot of the stage statistics of all threads, sorted by name.
+ */
+std::vector<StageStats> Profiler::stageStats() {
+  // The same literal may have a different address in every library.
+  std::unordered_map<std::string, StageTotals> totals{};
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (const auto &[name, stats] : m_retired.stages) {
+      mergeStage(totals[name], stats);
+    }
+    for (const std::unique_ptr<ThreadBuffer> &buffer : m_buffers) {
+      std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+      for (const auto &[name, stats] : buffer->stages) {
+        mergeStage(totals[name], stats);
+      }
+    }
+  }
+
+  std::vector<StageStats> stages{};
+  stages.reserve(totals.size());
+  for (const auto &[name, stats] : totals) {
+    stages.push_back(
+        {name, stats.count, stats.last_ms, stats.total_ms, stats.max_ms});
+  }
+  std::sort(stages.begin(), stages.end(),
+            [](const StageStats &a, const StageStats &b) {
+              return a.name < b.name;
+            });
+
+  return stages;
+}
+
+/**
+ * @brief Snapshot of the counter statistics of all threads, sorted by name.
+ */
+std::vector<CounterStats> Profiler::counterStats() {
+  std::unordered_map<std::string, CounterTotals> totals{};
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    for (const auto &[name, stats] : m_retired.counters) {
+      mergeCounter(totals[name], stats);
+    }
+    for (const std::unique_ptr<ThreadBuffer> &buffer : m_buffers) {
+      std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+      for (const auto &[name, stats] : buffer->counters) {
+        mergeCounter(totals[name], stats);
+      }
+    }
+  }
+
+  std::vector<CounterStats> counters{};
+  counters.reserve(totals.size());
+  for (const auto &[name, stats] : totals) {
+    counters.push_back({name, stats.count, stats.last, stats.total});
+  }
+  std::sort(counters.begin(), counters.end(),
+            [](const CounterStats &a, const CounterStats &b) {
+              return a.name < b.name;
+            });
+
+  return counters;
+}
+
+/**
+ * @brief Writes the recorded events of all threads in the Chrome trace event
+ *        format, at most the kMaxEvents latest.
+ *
+ * @param file_path JSON file to write.
+ * @return Whether the file has been written.
+ */
+bool Profiler::writeChromeTrace(const std::string &file_path) {
+  std::vector<TraceEvent> events{};
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    events = m_retired.events;
+    for (const std::unique_ptr<ThreadBuffer> &buffer : m_buffers) {
+      std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+      events.insert(events.end(), buffer->events.begin(),
+                    buffer->events.end());
+    }
+  }
+  std::stable_sort(events.begin(), events.end(),
+                   [](const TraceEvent &a, const TraceEvent &b) {
+                     return a.start_us < b.start_us;
+                   });
+  if (events.size() > kMaxEvents) {
+    events.erase(events.begin(), events.end() - kMaxEvents);
+  }
+
+  std::ofstream out{file_path, std::ios::trunc};
+  out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i != events.size(); ++i) {
+    const TraceEvent &event{events[i]};
+    out << (i == 0 ? "\n" : ",\n") << "{\"name\":";
+    writeJsonString(out, event.name);
+    if (event.duration_us >= 0) {
+      out << ",\"ph\":\"X\",\"dur\":" << event.duration_us;
+    } else {
+      out << ",\"ph\":\"C\",\"args\":{\"value\":" << event.value << "}";
+    }
+    out << ",\"ts\":" << event.start_us << ",\"pid\":1,\"tid\":"
+        << event.thread << "}";
+  }
+  out << "\n]}\n";
+
+  return static_cast<bool>(out);
+}
+
+void Profiler::reset() {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  m_retired.stages.clear();
+  m_retired.counters.clear();
+  m_retired.events.clear();
+  m_retired.next_event = 0;
+  for (const std::unique_ptr<ThreadBuffer> &buffer : m_buffers) {
+    std::lock_guard<std::mutex> buffer_lock{buffer->mutex};
+    buffer->stages.clear();
+    buffer->counters.clear();
+    buffer->events.clear();
+    buffer->next_event = 0;
+  }
+}
+
+/**
+ * @brief The calling thread's buffer, registered on the thread's first
+ *        record and folded into m_retired when the thread ends.
+ */
+Profiler::ThreadBuffer &Profiler::threadBuffer() {
+  struct Registration {
+    Profiler *profiler{nullptr};
+    ThreadBuffer *buffer{nullptr};
+    ~Registration() {
+      if (buffer != nullptr) {
+        profiler->retire(buffer);
+      }
+    }
+  };
+  thread_local Registration registration{};
+
+  if (registration.buffer == nullptr) {
+    auto buffer{std::make_unique<ThreadBuffer>()};
+    registration.profiler = this;
+    registration.buffer = buffer.get();
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_buffers.push_back(std::move(buffer));
+  }
+
+  return *registration.buffer;
+}
+
+void Profiler::retire(ThreadBuffer *buffer) {
+  std::lock_guard<std::mutex> lock{m_mutex};
+  auto it{std::find_if(m_buffers.begin(), m_buffers.end(),
+                       [buffer](const std::unique_ptr<ThreadBuffer> &elem) {
+                         return elem.get() == buffer;
+                       })};
+  if (it == m_buffers.end()) {
+    return;
+  }
+
+  for (const auto &[name, stats] : buffer->stages) {
+    mergeStage(m_retired.stages[name], stats);
+  }
+  for (const auto &[name, stats] : buffer->counters) {
+    mergeCounter(m_retired.counters[name], stats);
+  }
+  // Oldest first, the ring starts at the next slot to overwrite.
+  for (size_t i = 0; i != buffer->events.size(); ++i) {
+    addEvent(m_retired,
+             buffer->events[(buffer->next_event + i) % buffer->events.size()],
+             kMaxEvents);
+  }
+  m_buffers.erase(it);
+}
+
+// Called with the buffer's mutex held, or m_mutex for m_retired.
+void Profiler::addEvent(ThreadBuffer &buffer, const TraceEvent &event,
+                        size_t max_events) {
+  if (buffer.events.size() < max_events) {
+    buffer.events.push_back(event);
+    return;
+  }
+  buffer.events[buffer.next_event] = event;
+  buffer.next_event = (buffer.next_event + 1) % max_events;
+}
+
+void Profiler::mergeStage(StageTotals &into, const StageTotals &from) {
+  into.count += from.count;
+  into.total_ms += from.total_ms;
+  into.max_ms = std::max(into.max_ms, from.max_ms);
+  if (from.last_us >= into.last_us) {
+    into.last_ms = from.last_ms;
+    into.last_us = from.last_us;
+  }
+}
+
+void Profiler::mergeCounter(CounterTotals &into, const CounterTotals &from) {
+  into.count += from.count;
+  into.total += from.total;
+  if (from.last_us >= into.last_us) {
+    into.last = from.last;
+    into.last_us = from.last_us;
+  }
+}
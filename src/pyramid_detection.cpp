@@ -0,0 +1,166 @@
+#include "pyramid_detection.h"
+#include "profiler.h"
+#include "tiled_detection.h"
+
+#include <algorithm>
+#include <iterator>
+
+// Detection in two levels. The coarse level marks every block of the image
+// holding a pixel of the mask; its connected components, grown by the reach
+// of the closing, bound every object morphology can make of the mask. Only
+// those regions go through morphology and contour extraction at full
+// resolution, each read with the morphology halo around it, so the contours
+// are the same as those of the whole image. Images with few objects skip
+// most of the morphology, which costs the most of detection.
+
+namespace {
+cv::Rect expandRect(const cv::Rect &rect, int margin) {
+  return {rect.x - margin, rect.y - margin, rect.width + 2 * margin,
+          rect.height + 2 * margin};
+}
+
+/**
+ * @brief Marks the blocks of a mask holding any of its pixels.
+ */
+cv::Mat coarseMask(const cv::Mat &mask, int block_size) {
+  PROFILE_SCOPE("coarse mask");
+  cv::Mat coarse = cv::Mat::zeros((mask.rows + block_size - 1) / block_size,
+                                  (mask.cols + block_size - 1) / block_size,
+                                  CV_8UC1);
+  for (int y = 0; y != mask.rows; ++y) {
+    const uchar *src{mask.ptr<uchar>(y)};
+    uchar *dst{coarse.ptr<uchar>(y / block_size)};
+    for (int x = 0; x != mask.cols; ++x) {
+      dst[x / block_size] |= src[x];
+    }
+  }
+
+  return coarse;
+}
+
+/**
+ * @brief Joins the regions overlapping each other until none do.
+ */
+std::vector<cv::Rect> joinOverlapping(std::vector<cv::Rect> regions) {
+  for (bool joined = true; joined;) {
+    joined = false;
+    std::vector<cv::Rect> disjoint{};
+    for (const cv::Rect &region : regions) {
+      auto overlapping{std::find_if(
+          disjoint.begin(), disjoint.end(), [&region](const cv::Rect &other) {
+            return !(region & other).empty();
+          })};
+      if (overlapping != disjoint.end()) {
+        *overlapping |= region;
+        joined = true;
+      } else {
+        disjoint.push_back(region);
+      }
+    }
+    regions = std::move(disjoint);
+  }
+
+  return regions;
+}
+} // namespace
+
+/**
+ * @brief Detects contours at full resolution within the regions a coarse
+ *        level of the mask points to. The contours and their order are the
+ *        same as whole-image detection gives.
+ *
+ * @param rgb Image to process;
+ * @param options Coarse block size and the share of the image beyond which
+ *        refining regions stops paying;
+ * @param compute_mask Per-pixel mask of the objects, e.g. computeRedMask;
+ * @param morphology Morphology applied to the mask.
+ * @return The contours with their features.
+ */
+ContourStore
+detectPyramid(const cv::Mat &rgb, const PyramidOptions &options,
+              const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+              const MorphologySettings &morphology) {
+  PROFILE_SCOPE("detect pyramid");
+  cv::Mat mask{};
+  {
+    PROFILE_SCOPE("color mask");
+    compute_mask(rgb, mask);
+  }
+  cv::Mat coarse{coarseMask(mask, options.block_size)};
+
+  // Opening only removes pixels and closing adds them within its radius, so
+  // every object lies within that reach of the mask. One more pixel keeps
+  // objects of different regions from touching.
+  int reach{(morphology.close_size > 0 ? morphology.close_size / 2 : 0) + 1};
+  cv::Rect image_rect{0, 0, rgb.cols, rgb.rows};
+  std::vector<cv::Rect> regions{};
+  {
+    PROFILE_SCOPE("coarse regions");
+    cv::Mat labels{};
+    cv::Mat stats{};
+    cv::Mat centroids{};
+    int count{cv::connectedComponentsWithStats(coarse, labels, stats,
+                                               centroids, 8, CV_32S)};
+    // Label 0 is the background.
+    for (int i = 1; i < count; ++i) {
+      cv::Rect blocks{stats.at<int>(i, cv::CC_STAT_LEFT),
+                      stats.at<int>(i, cv::CC_STAT_TOP),
+                      stats.at<int>(i, cv::CC_STAT_WIDTH),
+                      stats.at<int>(i, cv::CC_STAT_HEIGHT)};
+      cv::Rect region{blocks.x * options.block_size,
+                      blocks.y * options.block_size,
+                      blocks.width * options.block_size,
+                      blocks.height * options.block_size};
+      regions.push_back(expandRect(region, reach) & image_rect);
+    }
+    regions = joinOverlapping(std::move(regions));
+  }
+
+  double region_area{0.0};
+  for (const cv::Rect &region : regions) {
+    region_area += region.area();
+  }
+  if (region_area > options.max_region_share * image_rect.area()) {
+    applyMorphology(mask, morphology);
+    return findExternalContours(mask);
+  }
+
+  int halo{morphologyHalo(morphology)};
+  std::vector<std::vector<cv::Point>> contours{};
+  cv::Mat region_mask{};
+  cv::Mat buffer{};
+  std::vector<std::vector<cv::Point>> found{};
+  for (const cv::Rect &region : regions) {
+    cv::Rect read_rect{expandRect(region, halo) & image_rect};
+    mask(read_rect).copyTo(region_mask);
+    applyMorphology(region_mask, morphology, buffer);
+    {
+      PROFILE_SCOPE("find contours");
+      cv::findContours(region_mask(region - read_rect.tl()), found,
+                       cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE,
+                       region.tl());
+    }
+    std::move(found.begin(), found.end(), std::back_inserter(contours));
+  }
+
+  // cv::findContours lists contours by their first point, the topmost
+  // leftmost one, in reverse raster order.
+  std::sort(contours.begin(), contours.end(),
+            [](const std::vector<cv::Point> &a,
+               const std::vector<cv::Point> &b) {
+              return a.front().y != b.front().y ? a.front().y > b.front().y
+                                                : a.front().x > b.front().x;
+            });
+
+  return ContourStore{contours};
+}
+
+/**
+ * @brief Pyramid counterpart of getContourVector, for full resolution images
+ *        with few objects.
+ */
+ContourStore getContourVectorPyramid(const cv::Mat &rgb,
+                                     const PyramidOptions &options) {
+  return detectPyramid(rgb, options, RedPreset::computeMask,
+                       RedPreset::kMorphology);
+}
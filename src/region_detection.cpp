@@ -0,0 +1,186 @@
+#include "region_detection.h"
+#include "profiler.h"
+#include "tiled_detection.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+
+// Only the mask within the dirty rectangle and the morphology halo around it
+// can change, so only the contours reaching into that area can. The area
+// detected again grows to the bounding boxes of those contours until no
+// other contour reaches into it: every object within it then lies within it
+// whole, and the contours found there replace the previous ones exactly.
+
+namespace {
+cv::Rect expandRect(const cv::Rect &rect, int margin) {
+  return {rect.x - margin, rect.y - margin, rect.width + 2 * margin,
+          rect.height + 2 * margin};
+}
+
+bool samePoints(ContourPoints a, ContourPoints b) {
+  return a.size == b.size && std::equal(a.begin(), a.end(), b.begin());
+}
+
+// A contour of the result, taken from the previous store or the new one.
+struct Slot {
+  bool from_previous{true};
+  size_t index{0};
+};
+} // namespace
+
+/**
+ * @brief Detects contours again within a dirty rectangle and splices them
+ *        into the previous contours, as if the whole image had been
+ *        detected again. Contours away from the rectangle keep their numbers;
+ *        the contours found in the region take the numbers of those they
+ *        replace, then numbers after the last. If the region ends up with
+ *        fewer contours, the last contours move into the numbers left free.
+ *
+ * @param rgb Image, with its changes;
+ * @param previous Contours detected on the image before the changes;
+ * @param dirty Rectangle holding every changed pixel, or every pixel the
+ *        changed mask settings apply to;
+ * @param compute_mask Per-pixel mask of the objects, e.g. computeRedMask;
+ * @param morphology Morphology applied to the mask, the same as for previous.
+ * @return Spliced contours and how the previous numbers map to them.
+ */
+RegionDetection
+redetectRegion(const cv::Mat &rgb, const ContourStore &previous,
+               const cv::Rect &dirty,
+               const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+               const MorphologySettings &morphology) {
+  PROFILE_SCOPE("redetect region");
+  cv::Rect image_rect{0, 0, rgb.cols, rgb.rows};
+  int halo{morphologyHalo(morphology)};
+
+  RegionDetection result{};
+  result.renumbered.resize(previous.size());
+  for (size_t i = 0; i != previous.size(); ++i) {
+    result.renumbered[i] = static_cast<int>(i);
+  }
+  // One more pixel than the halo, for the objects touching it.
+  cv::Rect region{expandRect(dirty, halo + 1) & image_rect};
+  if (region.empty()) {
+    result.contours = previous;
+    return result;
+  }
+
+  std::vector<bool> replaced(previous.size(), false);
+  for (bool grown = true; grown;) {
+    grown = false;
+    for (size_t i = 0; i != previous.size(); ++i) {
+      if (!replaced[i] && !(previous.bbox(i) & region).empty()) {
+        replaced[i] = true;
+        region |= previous.bbox(i);
+        grown = true;
+      }
+    }
+  }
+  result.region = region;
+
+  // The mask is computed with the halo, for morphology to be exact within
+  // the region.
+  cv::Rect read_rect{expandRect(region, halo) & image_rect};
+  cv::Mat mask{};
+  {
+    PROFILE_SCOPE("color mask");
+    compute_mask(rgb(read_rect), mask);
+  }
+  applyMorphology(mask, morphology);
+  ContourStore found{};
+  {
+    PROFILE_SCOPE("find contours");
+    std::vector<std::vector<cv::Point>> contours{};
+    cv::findContours(mask(region - read_rect.tl()), contours,
+                     cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE, region.tl());
+    found = ContourStore{contours};
+  }
+
+  // Contours the change did not touch keep their numbers.
+  std::map<std::pair<int, int>, std::vector<size_t>> replaced_by_start{};
+  std::vector<size_t> freed{};
+  for (size_t i = 0; i != previous.size(); ++i) {
+    if (replaced[i]) {
+      const cv::Point &start{previous[i].front()};
+      replaced_by_start[{start.y, start.x}].push_back(i);
+    }
+  }
+  std::vector<bool> matched(found.size(), false);
+  for (size_t j = 0; j != found.size(); ++j) {
+    const cv::Point &start{found[j].front()};
+    auto it{replaced_by_start.find({start.y, start.x})};
+    if (it == replaced_by_start.end()) {
+      continue;
+    }
+    for (size_t &i : it->second) {
+      if (i != SIZE_MAX && samePoints(previous[i], found[j])) {
+        replaced[i] = false;
+        matched[j] = true;
+        i = SIZE_MAX;
+        break;
+      }
+    }
+  }
+  for (size_t i = 0; i != previous.size(); ++i) {
+    if (replaced[i]) {
+      freed.push_back(i);
+      result.renumbered[i] = -1;
+    }
+  }
+
+  std::vector<Slot> slots(previous.size());
+  for (size_t i = 0; i != previous.size(); ++i) {
+    slots[i] = {true, i};
+  }
+  size_t next_freed{0};
+  for (size_t j = 0; j != found.size(); ++j) {
+    if (matched[j]) {
+      continue;
+    }
+    if (next_freed != freed.size()) {
+      slots[freed[next_freed++]] = {false, j};
+    } else {
+      slots.push_back({false, j});
+    }
+  }
+  // Numbers still free are filled from the end, so that the numbers stay
+  // contiguous.
+  std::vector<bool> is_free(slots.size(), false);
+  for (size_t k = next_freed; k != freed.size(); ++k) {
+    is_free[freed[k]] = true;
+  }
+  for (size_t k = next_freed; k != freed.size(); ++k) {
+    while (!slots.empty() && is_free[slots.size() - 1]) {
+      slots.pop_back();
+    }
+    size_t hole{freed[k]};
+    if (hole >= slots.size()) {
+      break;
+    }
+    slots[hole] = slots.back();
+    is_free[hole] = false;
+    if (slots.back().from_previous) {
+      result.renumbered[slots.back().index] = static_cast<int>(hole);
+    }
+    slots.pop_back();
+  }
+
+  result.contours.reserve(slots.size(),
+                          previous.pointCount() + found.pointCount());
+  for (const Slot &slot : slots) {
+    result.contours.append(slot.from_previous ? previous : found, slot.index);
+  }
+
+  return result;
+}
+
+/**
+ * @brief Region counterpart of getContourVector.
+ */
+RegionDetection getContourVectorRegion(const cv::Mat &rgb,
+                                       const ContourStore &previous,
+                                       const cv::Rect &dirty) {
+  return redetectRegion(rgb, previous, dirty, RedPreset::computeMask,
+                        RedPreset::kMorphology);
+}
@@ -1,15 +1,97 @@
 #include "sql_query_handler.h"
 
+/**
+ * @brief Prepares the statements used by the functions below. Has to be
+ *        called once for every new connection.
+ *
+ * @param conn Connection to the database.
+ */
+void prepareStatements(pqxx::connection &conn) {
+  // Images are keyed by their canonical path, matched exactly, which lets
+  // PostgreSQL use the unique index on image_path and keeps '_' and '%' in
+  // file names literal. Rows saved before paths were recorded are keyed by
+  // the image's name and are found by it until the image is saved again.
+  conn.prepare("select_contours",
+               "SELECT contour_numbers, contour_names FROM contours "
+               "WHERE image_path = $1 OR image_path = $2 "
+               "ORDER BY image_path = $1 DESC LIMIT 1");
+  conn.prepare("select_contours_batch",
+               "SELECT image_path, contour_numbers, contour_names "
+               "FROM contours WHERE image_path = ANY($1)");
+  conn.prepare("upsert_contours",
+               "INSERT INTO contours (image_path, image_name, "
+               "contour_numbers, contour_names) VALUES ($1, $2, $3, $4) "
+               "ON CONFLICT (image_path) DO UPDATE "
+               "SET image_name = EXCLUDED.image_name, "
+               "contour_numbers = EXCLUDED.contour_numbers, "
+               "contour_names = EXCLUDED.contour_names "
+               "RETURNING id_pk");
+  conn.prepare("delete_contours", "DELETE FROM contours WHERE image_path = $1");
+  conn.prepare("select_geometry",
+               "SELECT contour_geometry FROM contour_geometry "
+               "WHERE image_hash = $1 AND image_height = $2 "
+               "AND image_width = $3");
+  conn.prepare("upsert_geometry",
+               "INSERT INTO contour_geometry (image_hash, image_name, "
+               "image_height, image_width, contour_count, contour_geometry) "
+               "VALUES ($1, $2, $3, $4, $5, $6) "
+               "ON CONFLICT (image_hash, image_height, image_width) "
+               "DO UPDATE SET image_name = EXCLUDED.image_name, "
+               "contour_count = EXCLUDED.contour_count, "
+               "contour_geometry = EXCLUDED.contour_geometry");
+  conn.prepare("delete_contour_rows", "DELETE FROM contour WHERE image_id = $1");
+  conn.prepare("insert_contour_rows",
+               "INSERT INTO contour (image_id, number, name, bbox_x, bbox_y, "
+               "bbox_width, bbox_height, area) "
+               "SELECT $1, * FROM unnest($2::integer[], "
+               "$3::character varying[], $4::integer[], $5::integer[], "
+               "$6::integer[], $7::integer[], $8::double precision[])");
+}
+
 /**
  * @brief Adds image's name, its contours' numbers and names to the database.
  *
  * @param conn Connection to the database.
+ * @param img_path Image's canonical path, which identifies it.
  * @param img_name Image's name.
  * @param contours_to_add Contours' numbers and names.
+ * @param summaries Geometry of all found contours, indexed by contour
+ *        number. The image's rows of the normalized contour table are
+ *        rewritten from it; saved contours without geometry get no row.
+ * @return Whether the changes have been committed.
  */
-void addContoursToDb(
-    pqxx::connection &conn, const std::string &img_name,
-    const std::unordered_map<int, std::string> &contours_to_add) {
+bool addContoursToDb(
+    pqxx::connection &conn, const std::string &img_path,
+    const std::string &img_name,
+    const std::unordered_map<int, std::string> &contours_to_add,
+    const std::vector<ContourSummary> &summaries) {
+  pqxx::work work{conn};
+  try {
+    writeContours(work, img_path, img_name, contours_to_add, summaries);
+    work.commit();
+  } catch (...) {
+    work.abort();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Writes what addContoursToDb does within the caller's transaction,
+ *        so that it commits or rolls back together with other writes.
+ *        Errors are thrown.
+ *
+ * @param work Transaction to run in.
+ * @param img_path Image's canonical path, which identifies it.
+ * @param img_name Image's name.
+ * @param contours_to_add Contours' numbers and names.
+ * @param summaries Geometry of all found contours, indexed by contour number.
+ */
+void writeContours(pqxx::work &work, const std::string &img_path,
+                   const std::string &img_name,
+                   const std::unordered_map<int, std::string> &contours_to_add,
+                   const std::vector<ContourSummary> &summaries) {
   // pqxx allows adding an array of data by passing std::vector as a query
   // parameter. For that reason std::unordered_set is being split.
   std::vector<int> contour_numbers{};
@@ -19,70 +101,320 @@ void addContoursToDb(
     contour_names.push_back(elem.second);
   }
 
-  pqxx::work work{conn};
-  std::string query{"SELECT * FROM contours WHERE image_name LIKE $1"};
-  // If the image does NOT exist in the database:
-  if (work.exec_params(query, img_name).size() == 0) {
-    if (contour_numbers.empty()) {
-      return;
-    } else {
-      query =
-          "INSERT INTO contours (image_name, contour_numbers, contour_names) "
-          "VALUES ($1, $2, $3)";
-    }
+  if (contour_numbers.empty()) {
+    // Rows of the contour table are removed by ON DELETE CASCADE.
+    work.exec_prepared("delete_contours", img_path);
   } else {
-    if (contour_numbers.empty()) {
-      query = "DELETE FROM contours WHERE image_name LIKE $1";
-    } else {
-      query = "UPDATE contours "
-              "SET contour_numbers = $2, contour_names = $3 "
-              "WHERE image_name LIKE $1";
+    // The unique key on image_path turns the former SELECT followed by
+    // INSERT or UPDATE into a single statement.
+    int image_id{work.exec_prepared1("upsert_contours", img_path, img_name,
+                                     contour_numbers, contour_names)[0]
+                     .as<int>()};
+    // Rows of an earlier save go even without geometry to replace them.
+    insertContourRows(work, image_id, contours_to_add, summaries);
+  }
+}
+
+/**
+ * @brief Replaces an image's rows of the normalized contour table.
+ *
+ * @param work Transaction to run in.
+ * @param image_id Image's id_pk.
+ * @param contours Contours' numbers and names.
+ * @param summaries Geometry of all found contours, indexed by contour number.
+ */
+void insertContourRows(pqxx::work &work, int image_id,
+                       const std::unordered_map<int, std::string> &contours,
+                       const std::vector<ContourSummary> &summaries) {
+  std::vector<int> numbers{};
+  std::vector<std::string> names{};
+  std::vector<int> bbox_x{};
+  std::vector<int> bbox_y{};
+  std::vector<int> bbox_width{};
+  std::vector<int> bbox_height{};
+  std::vector<double> area{};
+  for (const auto &elem : contours) {
+    if (elem.first < 0 ||
+        elem.first >= static_cast<int>(summaries.size())) {
+      continue;
     }
+    const ContourSummary &summary{summaries[elem.first]};
+    numbers.push_back(elem.first);
+    names.push_back(elem.second);
+    bbox_x.push_back(summary.bbox_x);
+    bbox_y.push_back(summary.bbox_y);
+    bbox_width.push_back(summary.bbox_width);
+    bbox_height.push_back(summary.bbox_height);
+    area.push_back(summary.area);
   }
 
+  work.exec_prepared("delete_contour_rows", image_id);
+  work.exec_prepared("insert_contour_rows", image_id, numbers, names, bbox_x,
+                     bbox_y, bbox_width, bbox_height, area);
+}
+
+/**
+ * @brief Gets image's saved contours' numbers and names.
+ *
+ * @param conn Connection to the database.
+ * @param img_path Image's canonical path, which identifies it.
+ * @param img_name Image's name, the key of contours saved before paths were.
+ * @return An array of saved contours' numbers and names, empty if none have
+ *         been saved.
+ * @throws pqxx::failure if the query fails, which must not be mistaken for
+ *         an image without saved contours.
+ */
+std::vector<std::pair<int, std::string>>
+getContoursFromDb(pqxx::connection &conn, const std::string &img_path,
+                  const std::string &img_name) {
+  pqxx::work work{conn};
+  pqxx::result res{work.exec_prepared("select_contours", img_path, img_name)};
+  work.commit();
+
+  std::vector<std::pair<int, std::string>> added_contours{};
+  if (!res.empty()) {
+    // Element type cannot be deduced so it needs to be explicitly stated in the
+    // function call
+    pqxx::array<int> num_array = res[0][0].as_sql_array<int>();
+    pqxx::array<std::string> name_array = res[0][1].as_sql_array<std::string>();
+
+    for (size_t i = 0; i != num_array.size(); ++i) {
+      added_contours.push_back({num_array[i], name_array[i]});
+    }
+  }
+
+  return added_contours;
+}
+
+/**
+ * @brief Stores the geometry of all of an image's found contours, so that
+ *        reopening the image does not need detection and saved contour
+ *        numbers keep referring to the same contours.
+ *
+ * @param conn Connection to the database.
+ * @param image_hash Image's content hash.
+ * @param image_name Image's name, for reference only.
+ * @param img_height Height of the image the contours were found on.
+ * @param img_width Width of the image the contours were found on.
+ * @param contour_count Number of contours.
+ * @param geometry Contours packed by encodeContours.
+ * @return Whether the geometry has been committed.
+ */
+bool addContourGeometryToDb(pqxx::connection &conn,
+                            const std::string &image_hash,
+                            const std::string &image_name, int img_height,
+                            int img_width, int contour_count,
+                            const std::vector<uint8_t> &geometry) {
+  pqxx::work work{conn};
+  try {
+    writeContourGeometry(work, image_hash, image_name, img_height, img_width,
+                         contour_count, geometry);
+    work.commit();
+  } catch (...) {
+    work.abort();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Writes what addContourGeometryToDb does within the caller's
+ *        transaction. Errors are thrown.
+ *
+ * @param work Transaction to run in.
+ * @param image_hash Image's content hash.
+ * @param image_name Image's name, for reference only.
+ * @param img_height Height of the image the contours were found on.
+ * @param img_width Width of the image the contours were found on.
+ * @param contour_count Number of contours.
+ * @param geometry Contours packed by encodeContours.
+ */
+void writeContourGeometry(pqxx::work &work, const std::string &image_hash,
+                          const std::string &image_name, int img_height,
+                          int img_width, int contour_count,
+                          const std::vector<uint8_t> &geometry) {
+  std::basic_string<std::byte> bytes(
+      reinterpret_cast<const std::byte *>(geometry.data()), geometry.size());
+
+  work.exec_prepared("upsert_geometry", image_hash, image_name, img_height,
+                     img_width, contour_count, bytes);
+}
+
+/**
+ * @brief Gets the stored geometry of an image's contours.
+ *
+ * @param conn Connection to the database.
+ * @param image_hash Image's content hash.
+ * @param img_height Height of the image to detect on.
+ * @param img_width Width of the image to detect on.
+ * @param geometry Receives the contours packed by encodeContours.
+ * @return Whether geometry for an image of this size has been found.
+ */
+bool getContourGeometryFromDb(pqxx::connection &conn,
+                              const std::string &image_hash, int img_height,
+                              int img_width, std::vector<uint8_t> &geometry) {
+  pqxx::work work{conn};
+  pqxx::result res{};
+  try {
+    res = work.exec_prepared("select_geometry", image_hash, img_height,
+                             img_width);
+    work.commit();
+  } catch (...) {
+    work.abort();
+  }
+
+  if (res.empty()) {
+    return false;
+  }
+
+  std::basic_string<std::byte> bytes{
+      res[0][0].as<std::basic_string<std::byte>>()};
+  const uint8_t *begin{reinterpret_cast<const uint8_t *>(bytes.data())};
+  geometry.assign(begin, begin + bytes.size());
+
+  return true;
+}
+
+/**
+ * @brief Adds or replaces the saved contours of many images in a single
+ *        transaction. Images and their rows of the normalized contour table
+ *        are streamed into temporary tables with COPY and merged with
+ *        set-based statements, so the number of round-trips does not depend
+ *        on the number of images. Images with no contours are deleted, and
+ *        the contour rows of the others rewritten, as in addContoursToDb.
+ *
+ * @param conn Connection to the database.
+ * @param images Images' paths and names with their contours' numbers, names
+ *        and geometry. If a path repeats, its last entry wins.
+ * @return Whether the changes have been committed.
+ */
+bool addContoursToDbBatch(pqxx::connection &conn,
+                          const std::vector<ImageContours> &images) {
+  std::unordered_map<std::string, size_t> last_entry{};
+  for (size_t i = 0; i != images.size(); ++i) {
+    last_entry[images[i].image_path] = i;
+  }
+
+  pqxx::work work{conn};
   try {
-    // DELETE query requires just 1 parameter
-    // whereas INSERT and UPDATE queries need 3.
-    if (contour_numbers.empty()) {
-      work.exec_params(query, img_name);
-    } else {
-      work.exec_params(query, img_name, contour_numbers, contour_names);
+    work.exec("CREATE TEMP TABLE contours_staging ("
+              "image_path character varying, image_name character varying, "
+              "contour_numbers integer[], "
+              "contour_names character varying[]) ON COMMIT DROP");
+
+    pqxx::stream_to stream{pqxx::stream_to::table(
+        work, {"contours_staging"},
+        {"image_path", "image_name", "contour_numbers", "contour_names"})};
+    for (size_t i = 0; i != images.size(); ++i) {
+      if (last_entry[images[i].image_path] != i) {
+        continue;
+      }
+      std::vector<int> contour_numbers{};
+      std::vector<std::string> contour_names{};
+      for (const auto &elem : images[i].contours) {
+        contour_numbers.push_back(elem.first);
+        contour_names.push_back(elem.second);
+      }
+      stream.write_values(images[i].image_path, images[i].image_name,
+                          contour_numbers, contour_names);
+    }
+    stream.complete();
+
+    work.exec("CREATE TEMP TABLE contour_staging ("
+              "image_path character varying, number integer, "
+              "name character varying, bbox_x integer, bbox_y integer, "
+              "bbox_width integer, bbox_height integer, "
+              "area double precision) ON COMMIT DROP");
+    pqxx::stream_to row_stream{pqxx::stream_to::table(
+        work, {"contour_staging"},
+        {"image_path", "number", "name", "bbox_x", "bbox_y", "bbox_width",
+         "bbox_height", "area"})};
+    for (size_t i = 0; i != images.size(); ++i) {
+      if (last_entry[images[i].image_path] != i) {
+        continue;
+      }
+      const std::vector<ContourSummary> &summaries{images[i].summaries};
+      for (const auto &elem : images[i].contours) {
+        if (elem.first < 0 ||
+            elem.first >= static_cast<int>(summaries.size())) {
+          continue;
+        }
+        const ContourSummary &summary{summaries[elem.first]};
+        row_stream.write_values(images[i].image_path, elem.first, elem.second,
+                                summary.bbox_x, summary.bbox_y,
+                                summary.bbox_width, summary.bbox_height,
+                                summary.area);
+      }
     }
+    row_stream.complete();
+
+    work.exec("DELETE FROM contours c USING contours_staging s "
+              "WHERE c.image_path = s.image_path "
+              "AND cardinality(s.contour_numbers) = 0");
+    work.exec("INSERT INTO contours (image_path, image_name, contour_numbers, "
+              "contour_names) "
+              "SELECT s.image_path, s.image_name, s.contour_numbers, "
+              "s.contour_names "
+              "FROM contours_staging s "
+              "WHERE cardinality(s.contour_numbers) > 0 "
+              "ON CONFLICT (image_path) DO UPDATE "
+              "SET image_name = EXCLUDED.image_name, "
+              "contour_numbers = EXCLUDED.contour_numbers, "
+              "contour_names = EXCLUDED.contour_names");
+    // Rows of deleted images went with them by ON DELETE CASCADE.
+    work.exec("DELETE FROM contour r USING contours c, contours_staging s "
+              "WHERE r.image_id = c.id_pk AND c.image_path = s.image_path");
+    work.exec("INSERT INTO contour (image_id, number, name, bbox_x, bbox_y, "
+              "bbox_width, bbox_height, area) "
+              "SELECT c.id_pk, r.number, r.name, r.bbox_x, r.bbox_y, "
+              "r.bbox_width, r.bbox_height, r.area "
+              "FROM contour_staging r "
+              "JOIN contours c ON c.image_path = r.image_path");
     work.commit();
   } catch (...) {
     work.abort();
+    return false;
   }
+
+  return true;
 }
 
 /**
- * @brief Gets image's saved contours' numbers and names.
+ * @brief Gets the saved contours' numbers and names of many images with a
+ *        single query.
  *
  * @param conn Connection to the database.
- * @param img_name Image's name.
- * @return An array of saved contours' numbers and names.
+ * @param image_paths Images' canonical paths.
+ * @return Saved contours' numbers and names per image path. Images without
+ *         saved contours are absent.
  */
-std::vector<std::pair<int, std::string>>
-getContoursFromDb(pqxx::connection &conn, const std::string &img_name) {
+std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>
+getContoursFromDbBatch(pqxx::connection &conn,
+                       const std::vector<std::string> &image_paths) {
+  std::unordered_map<std::string, std::vector<std::pair<int, std::string>>>
+      added_contours{};
+  if (image_paths.empty()) {
+    return added_contours;
+  }
+
   pqxx::work work{conn};
-  std::string query{"SELECT contour_numbers, contour_names FROM contours "
-                    "WHERE image_name LIKE $1"};
   pqxx::result res{};
   try {
-    res = work.exec_params(query, img_name);
+    res = work.exec_prepared("select_contours_batch", image_paths);
     work.commit();
   } catch (...) {
     work.abort();
   }
 
-  std::vector<std::pair<int, std::string>> added_contours{};
-  if (!res.empty()) {
-    // Element type cannot be deduced so it needs to be explicitly stated in the
-    // function call
-    pqxx::array<int> num_array = res[0][0].as_sql_array<int>();
-    pqxx::array<std::string> name_array = res[0][1].as_sql_array<std::string>();
+  for (const pqxx::row &row : res) {
+    pqxx::array<int> num_array = row[1].as_sql_array<int>();
+    pqxx::array<std::string> name_array = row[2].as_sql_array<std::string>();
 
+    std::vector<std::pair<int, std::string>> &contours{
+        added_contours[row[0].as<std::string>()]};
     for (size_t i = 0; i != num_array.size(); ++i) {
-      added_contours.push_back({num_array[i], name_array[i]});
+      contours.push_back({num_array[i], name_array[i]});
     }
   }
 
@@ -0,0 +1,126 @@
+#include "stats_panel.h"
+#include "profiler.h"
+
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QVBoxLayout>
+
+namespace {
+QTableWidget *createStatsTable(const QStringList &headers, QWidget *parent) {
+  QTableWidget *table = new QTableWidget{0, static_cast<int>(headers.size()),
+                                         parent};
+  table->setHorizontalHeaderLabels(headers);
+  table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+  table->verticalHeader()->hide();
+  table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  table->setSelectionMode(QAbstractItemView::NoSelection);
+
+  return table;
+}
+
+void setCell(QTableWidget *table, int row, int column, const QString &text) {
+  QTableWidgetItem *item = table->item(row, column);
+  if (item == nullptr) {
+    item = new QTableWidgetItem{};
+    if (column != 0) {
+      item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    }
+    table->setItem(row, column, item);
+  }
+  item->setText(text);
+}
+} // namespace
+
+StatsPanel::StatsPanel(QWidget *parent) : QWidget(parent, Qt::Window) {
+  setWindowTitle("Timing Statistics");
+  resize(560, 480);
+
+  status_label = new QLabel{this};
+  if (!Profiler::kEnabled) {
+    status_label->setText("Profiling is disabled in this build "
+                          "(CONTOURS_ENABLE_PROFILING).");
+  }
+  stages_table = createStatsTable(
+      {"Stage", "Count", "Last, ms", "Average, ms", "Max, ms"}, this);
+  counters_table =
+      createStatsTable({"Counter", "Count", "Last", "Average"}, this);
+  reset_button = new QPushButton{"Reset", this};
+  export_button = new QPushButton{"Export Trace...", this};
+
+  QHBoxLayout *buttons_layout = new QHBoxLayout{};
+  buttons_layout->addWidget(status_label, 1);
+  buttons_layout->addWidget(reset_button);
+  buttons_layout->addWidget(export_button);
+
+  QVBoxLayout *layout = new QVBoxLayout{this};
+  layout->addWidget(stages_table, 3);
+  layout->addWidget(counters_table, 1);
+  layout->addLayout(buttons_layout);
+
+  refresh_timer = new QTimer{this};
+  refresh_timer->setInterval(500);
+
+  connect(refresh_timer, &QTimer::timeout, this, &StatsPanel::refresh);
+  connect(reset_button, &QPushButton::clicked, this, &StatsPanel::resetStats);
+  connect(export_button, &QPushButton::clicked, this,
+          &StatsPanel::exportTrace);
+}
+
+StatsPanel::~StatsPanel() {}
+
+void StatsPanel::showEvent(QShowEvent *event) {
+  refresh();
+  refresh_timer->start();
+  QWidget::showEvent(event);
+}
+
+void StatsPanel::hideEvent(QHideEvent *event) {
+  refresh_timer->stop();
+  QWidget::hideEvent(event);
+}
+
+void StatsPanel::refresh() {
+  std::vector<StageStats> stages{Profiler::instance().stageStats()};
+  stages_table->setRowCount(static_cast<int>(stages.size()));
+  for (int row = 0; row != static_cast<int>(stages.size()); ++row) {
+    const StageStats &stats{stages[row]};
+    setCell(stages_table, row, 0, QString::fromStdString(stats.name));
+    setCell(stages_table, row, 1, QString::number(stats.count));
+    setCell(stages_table, row, 2, QString::number(stats.last_ms, 'f', 2));
+    setCell(stages_table, row, 3,
+            QString::number(stats.total_ms / stats.count, 'f', 2));
+    setCell(stages_table, row, 4, QString::number(stats.max_ms, 'f', 2));
+  }
+
+  std::vector<CounterStats> counters{Profiler::instance().counterStats()};
+  counters_table->setRowCount(static_cast<int>(counters.size()));
+  for (int row = 0; row != static_cast<int>(counters.size()); ++row) {
+    const CounterStats &stats{counters[row]};
+    setCell(counters_table, row, 0, QString::fromStdString(stats.name));
+    setCell(counters_table, row, 1, QString::number(stats.count));
+    setCell(counters_table, row, 2, QString::number(stats.last));
+    setCell(counters_table, row, 3,
+            QString::number(static_cast<double>(stats.total) / stats.count,
+                            'f', 1));
+  }
+}
+
+void StatsPanel::resetStats() {
+  Profiler::instance().reset();
+  refresh();
+}
+
+void StatsPanel::exportTrace() {
+  QString file_path{QFileDialog::getSaveFileName(
+      this, "Export Trace", "contours_trace.json", "Trace (*.json)")};
+  if (file_path.isEmpty()) {
+    return;
+  }
+
+  if (!Profiler::instance().writeChromeTrace(file_path.toStdString())) {
+    QMessageBox::warning(this, "Export Trace",
+                         "Could not write " + file_path + ".");
+  }
+}
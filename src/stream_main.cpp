@@ -0,0 +1,88 @@
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include "stream_processor.h"
+
+namespace {
+void printUsage(const char *program) {
+  std::cerr << "Usage: " << program
+            << " [-j THREADS] [-o OUTPUT_DIR] [--max-height PIXELS]"
+               " [--queue FRAMES] [--max-distance PIXELS]"
+               " <video file or image pattern, e.g. frames/%04d.png>\n";
+}
+
+void printStage(const char *name, double seconds, size_t frames) {
+  std::cout << "  " << std::left << std::setw(8) << name << std::right
+            << std::setw(10) << seconds << " s total, " << std::setw(8)
+            << (frames == 0 ? 0.0 : seconds * 1000.0 / frames)
+            << " ms/frame\n";
+}
+} // namespace
+
+int main(int argc, char *argv[]) {
+  StreamOptions options{};
+  std::string source{};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg{argv[i]};
+    if ((arg == "-j" || arg == "-o" || arg == "--max-height" ||
+         arg == "--queue" || arg == "--max-distance") &&
+        i + 1 < argc) {
+      std::string value{argv[++i]};
+      if (arg == "-j") {
+        options.thread_count = std::strtoul(value.c_str(), nullptr, 10);
+      } else if (arg == "-o") {
+        options.output_dir = value;
+      } else if (arg == "--queue") {
+        options.queue_capacity = std::strtoul(value.c_str(), nullptr, 10);
+      } else if (arg == "--max-distance") {
+        options.tracker.max_centroid_distance = std::atof(value.c_str());
+      } else {
+        options.max_height = std::atoi(value.c_str());
+      }
+    } else if (arg == "-h" || arg == "--help") {
+      printUsage(argv[0]);
+      return 0;
+    } else if (!arg.empty() && arg[0] == '-') {
+      printUsage(argv[0]);
+      return 1;
+    } else if (source.empty()) {
+      source = arg;
+    } else {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  if (source.empty()) {
+    printUsage(argv[0]);
+    return 1;
+  }
+
+  StreamReport report{};
+  try {
+    report = runStream(source, options);
+  } catch (const std::runtime_error &error) {
+    std::cerr << error.what() << "\n";
+    return 1;
+  }
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "Processed " << report.frames_processed << " frames ("
+            << report.frames_failed << " failed), " << report.contours_found
+            << " contours, " << report.tracks_started << " objects in "
+            << report.wall_seconds << " s: "
+            << (report.wall_seconds > 0.0
+                    ? report.frames_processed / report.wall_seconds
+                    : 0.0)
+            << " frames/s\n";
+  std::cout << "Stage timings (summed over threads):\n";
+  size_t frames{report.frames_processed + report.frames_failed};
+  printStage("decode", report.decode_seconds, frames);
+  printStage("detect", report.detect_seconds, frames);
+  printStage("track", report.track_seconds, frames);
+
+  return report.frames_failed == 0 ? 0 : 2;
+}
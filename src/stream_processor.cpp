@@ -0,0 +1,197 @@
+#include "stream_processor.h"
+#include "bounded_queue.h"
+#include "contour_detection.h"
+#include "profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Frames flow through three stages joined by bounded queues: one thread
+// decodes, a pool of threads detects, and the calling thread puts the frames
+// back in order, tracks their contours and writes the results. Detection is
+// the only stage that depends on its own frame alone, so it is the one run in
+// parallel.
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+struct DecodedFrame {
+  size_t index{0};
+  cv::Mat rgb{};
+};
+
+struct DetectedFrame {
+  size_t index{0};
+  bool failed{false};
+  ContourStore contours{};
+};
+
+int64_t elapsedNs(Clock::time_point since) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              since)
+      .count();
+}
+} // namespace
+
+/**
+ * @brief Detects and tracks contours over the frames of a video file or of a
+ *        numbered image sequence, such as "frames/img_%04d.png". Writes to the
+ *        output directory:
+ *        - tracks.txt, a line per contour per frame: frame number, track id,
+ *          bounding box x, y, width and height, and area;
+ *        - objects.contours, the contour of every track as first seen, in
+ *          the format of writeContoursFile with track ids for numbers.
+ *
+ * @param source Video file or image sequence pattern, as cv::VideoCapture
+ *        takes them;
+ * @param options Output directory, threads, queue sizes and tracking bounds.
+ * @return Counters and per-stage timings of the run.
+ * @throws std::runtime_error if the source or the output cannot be opened.
+ */
+StreamReport runStream(const std::string &source, const StreamOptions &options) {
+  cv::VideoCapture capture{source};
+  if (!capture.isOpened()) {
+    throw std::runtime_error("Cannot open " + source);
+  }
+  std::filesystem::create_directories(options.output_dir);
+  std::ofstream tracks_file{
+      std::filesystem::path(options.output_dir) / "tracks.txt"};
+  std::ofstream objects_file{
+      std::filesystem::path(options.output_dir) / "objects.contours"};
+  if (!tracks_file || !objects_file) {
+    throw std::runtime_error("Cannot write to " + options.output_dir);
+  }
+
+  size_t thread_count{options.thread_count == 0
+                          ? std::max(1u, std::thread::hardware_concurrency())
+                          : options.thread_count};
+  BoundedQueue<DecodedFrame> decoded{options.queue_capacity};
+  BoundedQueue<DetectedFrame> detected{options.queue_capacity};
+  // A frame takes a slot when it is decoded and frees it once tracked. This
+  // bounds the frames waiting to be put back in order behind a slow one.
+  BoundedQueue<char> in_flight{2 * options.queue_capacity + thread_count};
+
+  std::atomic<int64_t> decode_ns{0};
+  std::atomic<int64_t> detect_ns{0};
+  std::atomic<size_t> detectors_running{thread_count};
+
+  Clock::time_point stream_start{Clock::now()};
+  std::thread decoder{[&]() {
+    for (size_t index = 0;; ++index) {
+      if (!in_flight.push(0)) {
+        break;
+      }
+      Clock::time_point stage_start{Clock::now()};
+      DecodedFrame frame{index, {}};
+      cv::Mat bgr{};
+      {
+        PROFILE_SCOPE("decode frame");
+        if (!capture.read(bgr) || bgr.empty()) {
+          break;
+        }
+        // Same size limit as the one the batch applies.
+        if (options.max_height > 0 && bgr.rows > options.max_height) {
+          cv::resize(bgr, bgr,
+                     cv::Size(bgr.cols * options.max_height / bgr.rows,
+                              options.max_height),
+                     0, 0, cv::INTER_AREA);
+        }
+        // getContourVector expects RGB.
+        cv::cvtColor(bgr, frame.rgb, cv::COLOR_BGR2RGB);
+      }
+      decode_ns += elapsedNs(stage_start);
+      if (!decoded.push(std::move(frame))) {
+        break;
+      }
+    }
+    decoded.close();
+  }};
+
+  std::vector<std::thread> detectors{};
+  for (size_t i = 0; i != thread_count; ++i) {
+    detectors.emplace_back([&]() {
+      DecodedFrame frame{};
+      // Frames of a stream share their size, so after the first one
+      // detection works in the same buffers.
+      DetectionScratch scratch{};
+      while (decoded.pop(frame)) {
+        Clock::time_point stage_start{Clock::now()};
+        DetectedFrame result{frame.index, false, {}};
+        try {
+          getContourVector(frame.rgb, scratch, result.contours);
+        } catch (...) {
+          // Still passed on, so that the frames after it are not held up.
+          result.failed = true;
+        }
+        frame.rgb.release();
+        detect_ns += elapsedNs(stage_start);
+        detected.push(std::move(result));
+      }
+      if (--detectors_running == 0) {
+        detected.close();
+      }
+    });
+  }
+
+  StreamReport report{};
+  ContourTracker tracker{options.tracker};
+  int64_t track_ns{0};
+  std::map<size_t, DetectedFrame> pending{};
+  size_t next_index{0};
+  DetectedFrame result{};
+  while (detected.pop(result)) {
+    pending.emplace(result.index, std::move(result));
+    for (auto it = pending.find(next_index); it != pending.end();
+         it = pending.find(++next_index)) {
+      DetectedFrame &frame{it->second};
+      Clock::time_point stage_start{Clock::now()};
+      if (frame.failed) {
+        ++report.frames_failed;
+      } else {
+        std::vector<TrackedContour> tracked{tracker.update(frame.contours)};
+        for (size_t i = 0; i != frame.contours.size(); ++i) {
+          const cv::Rect &bbox{frame.contours.bbox(i)};
+          tracks_file << frame.index << ' ' << tracked[i].track_id << ' '
+                      << bbox.x << ' ' << bbox.y << ' ' << bbox.width << ' '
+                      << bbox.height << ' ' << frame.contours.area(i) << '\n';
+          // Objects seen before are not stored again.
+          if (tracked[i].is_new) {
+            ContourPoints contour{frame.contours[i]};
+            objects_file << tracked[i].track_id << ' ' << contour.size;
+            for (const cv::Point &point : contour) {
+              objects_file << ' ' << point.x << ' ' << point.y;
+            }
+            objects_file << '\n';
+          }
+        }
+        ++report.frames_processed;
+        report.contours_found += frame.contours.size();
+      }
+      track_ns += elapsedNs(stage_start);
+      pending.erase(it);
+      char slot{};
+      in_flight.pop(slot);
+    }
+  }
+
+  // Only reached once every detector is done, after the decoder's last frame.
+  decoder.join();
+  for (std::thread &detector : detectors) {
+    detector.join();
+  }
+
+  report.tracks_started = static_cast<size_t>(tracker.tracksStarted());
+  report.wall_seconds =
+      std::chrono::duration<double>(Clock::now() - stream_start).count();
+  report.decode_seconds = decode_ns * 1e-9;
+  report.detect_seconds = detect_ns * 1e-9;
+  report.track_seconds = track_ns * 1e-9;
+
+  return report;
+}
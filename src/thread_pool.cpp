@@ -0,0 +1,128 @@
+#include "thread_pool.h"
+
+namespace {
+// Lets submit() called from inside a task push to the caller's own queue.
+thread_local const ThreadPool *t_pool{nullptr};
+thread_local size_t t_queue_index{0};
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = 1;
+  }
+
+  for (size_t i = 0; i != thread_count; ++i) {
+    m_queues.push_back(std::make_unique<WorkQueue>());
+  }
+  for (size_t i = 0; i != thread_count; ++i) {
+    m_workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_stopping = true;
+  }
+  m_task_available.notify_all();
+
+  for (std::thread &worker : m_workers) {
+    worker.join();
+  }
+}
+
+/**
+ * @brief Queues a task. Tasks submitted from a worker go to that worker's own
+ *        queue, others are spread round-robin.
+ *
+ * @param task Task to run. It must not throw.
+ */
+void ThreadPool::submit(std::function<void()> task) {
+  size_t index{t_pool == this ? t_queue_index
+                              : m_next_queue++ % m_queues.size()};
+
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    ++m_unfinished;
+  }
+  {
+    std::lock_guard<std::mutex> lock{m_queues[index]->mutex};
+    m_queues[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    ++m_queued;
+  }
+  m_task_available.notify_one();
+}
+
+/**
+ * @brief Blocks until every submitted task has finished. Must not be called
+ *        from inside a task.
+ */
+void ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock{m_mutex};
+  m_all_done.wait(lock, [this]() { return m_unfinished == 0; });
+}
+
+void ThreadPool::workerLoop(size_t index) {
+  t_pool = this;
+  t_queue_index = index;
+
+  while (true) {
+    std::function<void()> task{};
+    if (popTask(index, task)) {
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        --m_queued;
+      }
+      task();
+      {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        if (--m_unfinished == 0) {
+          m_all_done.notify_all();
+        }
+      }
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_task_available.wait(lock,
+                          [this]() { return m_stopping || m_queued > 0; });
+    if (m_stopping && m_queued <= 0) {
+      return;
+    }
+  }
+}
+
+/**
+ * @brief Takes the newest task of the worker's own queue, or steals the oldest
+ *        task of another worker's queue.
+ *
+ * @param index Worker's queue index;
+ * @param task Receives the task.
+ * @return Whether a task has been found.
+ */
+bool ThreadPool::popTask(size_t index, std::function<void()> &task) {
+  {
+    WorkQueue &own{*m_queues[index]};
+    std::lock_guard<std::mutex> lock{own.mutex};
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      return true;
+    }
+  }
+
+  for (size_t offset = 1; offset != m_queues.size(); ++offset) {
+    WorkQueue &victim{*m_queues[(index + offset) % m_queues.size()]};
+    std::lock_guard<std::mutex> lock{victim.mutex};
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
@@ -0,0 +1,443 @@
+#include "tiled_detection.h"
+#include "contour_detection.h"
+#include "thread_pool.h"
+
+#include <QImageReader>
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+
+// Detection runs on horizontal strips of the image. Every strip is read with
+// enough rows above and below it (the halo) for morphology to give the same
+// mask as on the whole image, so only the contours crossing a cut between
+// strips need stitching. Those are kept as filled masks of their bounding
+// boxes, joined where their pixels touch across the cut and traced again.
+// Memory is bounded by the strips in flight plus the objects crossing cuts.
+
+namespace {
+using Contour = std::vector<cv::Point>;
+
+// A contour touching a cut, not final until joined with what lies across.
+struct Piece {
+  int strip{0};
+  cv::Rect bbox{};
+  cv::Mat filled{};
+};
+
+struct StripResult {
+  std::vector<Contour> closed{};
+  std::vector<Piece> open{};
+};
+
+int findRoot(std::vector<int> &parent, int i) {
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+
+  return i;
+}
+
+// Qt refuses to decode images needing more than 256 MB by default, which
+// rules out the scans tiled detection is for. This allows a 2 gigapixel
+// image decoded as 32-bit pixels.
+constexpr int kImageAllocationLimitMb{8192};
+
+void raiseImageAllocationLimit() {
+  static std::once_flag once{};
+  std::call_once(once, []() {
+    QImageReader::setAllocationLimit(kImageAllocationLimitMb);
+  });
+}
+
+// Created on first use and kept, so that detecting an image in bands does
+// not start and join a thread per core every time.
+ThreadPool &bandPool() {
+  static ThreadPool pool{std::max(1u, std::thread::hardware_concurrency())};
+  return pool;
+}
+
+StripResult detectStrip(
+    const StripSource &source, int strip, int strip_rows, int halo,
+    const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+    const MorphologySettings &morphology) {
+  PROFILE_SCOPE("detect strip");
+  int first_row{strip * strip_rows};
+  int end_row{std::min(source.height, first_row + strip_rows)};
+  int read_first{std::max(0, first_row - halo)};
+  int read_end{std::min(source.height, end_row + halo)};
+
+  cv::Mat rgb{};
+  {
+    PROFILE_SCOPE("read strip");
+    if (!source.read(read_first, read_end - read_first, rgb) ||
+        rgb.rows != read_end - read_first || rgb.cols != source.width) {
+      throw std::runtime_error("Cannot read image rows");
+    }
+  }
+  cv::Mat mask{};
+  {
+    PROFILE_SCOPE("color mask");
+    compute_mask(rgb, mask);
+  }
+  rgb.release();
+  applyMorphology(mask, morphology);
+  // Rows of the halo only served morphology.
+  mask = mask.rowRange(first_row - read_first, end_row - read_first);
+
+  std::vector<Contour> contours{};
+  {
+    PROFILE_SCOPE("find contours");
+    cv::findContours(mask, contours, cv::RETR_EXTERNAL,
+                     cv::CHAIN_APPROX_SIMPLE, cv::Point(0, first_row));
+  }
+
+  StripResult result{};
+  for (Contour &contour : contours) {
+    cv::Rect bbox{cv::boundingRect(contour)};
+    bool touches_top{bbox.y == first_row && first_row > 0};
+    bool touches_bottom{bbox.y + bbox.height == end_row &&
+                        end_row < source.height};
+    if (!touches_top && !touches_bottom) {
+      result.closed.push_back(std::move(contour));
+      continue;
+    }
+
+    // Filling also covers the contour's holes, which does not change the
+    // outer contour of what the piece joins with.
+    cv::Mat filled = cv::Mat::zeros(bbox.height, bbox.width, CV_8UC1);
+    cv::drawContours(filled, std::vector<Contour>{contour}, 0,
+                     cv::Scalar(255), cv::FILLED, cv::LINE_8, cv::noArray(),
+                     INT_MAX, -bbox.tl());
+    result.open.push_back(Piece{strip, bbox, filled});
+  }
+
+  return result;
+}
+
+// Joins pieces whose pixels are 8-connected across the cut below strip.
+void linkAcrossCut(const std::vector<Piece> &pieces,
+                   const std::vector<int> &above, const std::vector<int> &below,
+                   int cut_row, int img_width, std::vector<int> &parent) {
+  std::vector<int> above_row(img_width, -1);
+  std::vector<int> below_row(img_width, -1);
+  for (int i : above) {
+    const Piece &piece{pieces[i]};
+    if (piece.bbox.y + piece.bbox.height != cut_row) {
+      continue;
+    }
+    const uchar *row{piece.filled.ptr<uchar>(piece.bbox.height - 1)};
+    for (int x = 0; x != piece.bbox.width; ++x) {
+      if (row[x] != 0) {
+        above_row[piece.bbox.x + x] = i;
+      }
+    }
+  }
+  for (int i : below) {
+    const Piece &piece{pieces[i]};
+    if (piece.bbox.y != cut_row) {
+      continue;
+    }
+    const uchar *row{piece.filled.ptr<uchar>(0)};
+    for (int x = 0; x != piece.bbox.width; ++x) {
+      if (row[x] != 0) {
+        below_row[piece.bbox.x + x] = i;
+      }
+    }
+  }
+
+  for (int x = 0; x != img_width; ++x) {
+    if (above_row[x] < 0) {
+      continue;
+    }
+    for (int dx = -1; dx <= 1; ++dx) {
+      int nx{x + dx};
+      if (nx >= 0 && nx < img_width && below_row[nx] >= 0) {
+        parent[findRoot(parent, above_row[x])] =
+            findRoot(parent, below_row[nx]);
+      }
+    }
+  }
+}
+} // namespace
+
+/**
+ * @brief Strips of an image already in memory.
+ *
+ * @param rgb RGB image, whose pixels the source shares.
+ */
+StripSource matStripSource(const cv::Mat &rgb) {
+  StripSource source{rgb.rows, rgb.cols, {}};
+  source.read = [rgb](int first_row, int row_count, cv::Mat &strip) {
+    strip = rgb.rowRange(first_row, first_row + row_count);
+    return true;
+  };
+
+  return source;
+}
+
+/**
+ * @brief Strips of an image file. Formats whose Qt plugin supports clip
+ *        rectangles decode only the rows asked for; others are decoded once,
+ *        whole, and the strips are views of the decoded image. JPEG is
+ *        decoded whole as well: its plugin has to decode every row above a
+ *        clip rectangle, which makes reading strip by strip quadratic in the
+ *        number of strips. Neither PNG nor JPEG is therefore read strip by
+ *        strip; for them only detection is bounded by the strip size.
+ *
+ * @param file_path Image file.
+ * @return Source with a zero size if the file cannot be read.
+ */
+StripSource fileStripSource(const std::string &file_path) {
+  raiseImageAllocationLimit();
+  QString path{QString::fromStdString(file_path)};
+  QImageReader reader{path};
+  QSize size{reader.size()};
+  if (!reader.supportsOption(QImageIOHandler::ClipRect) || !size.isValid() ||
+      reader.format() == "jpeg") {
+    QImage image{reader.read()};
+    if (image.isNull()) {
+      return {};
+    }
+    image.convertTo(QImage::Format_RGB888);
+    // The source owns the image and wraps its rows, so the pixels are not
+    // copied again.
+    StripSource source{image.height(), image.width(), {}};
+    source.read = [image](int first_row, int row_count, cv::Mat &strip) {
+      strip = wrapQImageAsCvMat(image).rowRange(first_row,
+                                                first_row + row_count);
+      return true;
+    };
+    return source;
+  }
+
+  StripSource source{size.height(), size.width(), {}};
+  source.read = [path, width = size.width()](int first_row, int row_count,
+                                             cv::Mat &strip) {
+    // A reader only reads once and is not thread-safe, each strip gets one.
+    QImageReader strip_reader{path};
+    strip_reader.setClipRect(QRect(0, first_row, width, row_count));
+    QImage image{strip_reader.read()};
+    if (image.isNull()) {
+      return false;
+    }
+    image.convertTo(QImage::Format_RGB888);
+    strip = wrapQImageAsCvMat(image).clone();
+    return true;
+  };
+
+  return source;
+}
+
+/**
+ * @brief Rows beyond a strip that morphology reads to compute the strip's
+ *        rows exactly: every erosion or dilation reaches as far as its
+ *        kernel's radius, and opening and closing apply two each.
+ */
+int morphologyHalo(const MorphologySettings &morphology) {
+  int halo{0};
+  if (morphology.open_size > 0) {
+    halo += 2 * (morphology.open_size / 2);
+  }
+  if (morphology.close_size > 0) {
+    halo += 2 * (morphology.close_size / 2);
+  }
+
+  return halo;
+}
+
+/**
+ * @brief Detects external contours strip by strip, in parallel. Gives the
+ *        same contours, in the same order, as detecting on the whole image.
+ *
+ * @param source Image to process;
+ * @param options Strip height and thread count;
+ * @param compute_mask Per-pixel mask of the objects, e.g. computeRedMask;
+ * @param morphology Morphology applied to the mask.
+ * @return The contours with their features.
+ * @throws std::runtime_error if the source fails to read a strip.
+ */
+ContourStore
+detectTiled(const StripSource &source, const TileOptions &options,
+            const std::function<void(const cv::Mat &, cv::Mat &)> &compute_mask,
+            const MorphologySettings &morphology) {
+  if (source.height <= 0 || source.width <= 0) {
+    return {};
+  }
+
+  int strip_rows{std::max(1, options.strip_rows)};
+  int strip_count{(source.height + strip_rows - 1) / strip_rows};
+  int halo{morphologyHalo(morphology)};
+
+  std::vector<StripResult> strips(strip_count);
+  std::atomic<bool> failed{false};
+  std::unique_ptr<ThreadPool> own_pool{};
+  ThreadPool *pool{options.pool};
+  if (pool == nullptr) {
+    own_pool = std::make_unique<ThreadPool>(
+        options.thread_count == 0 ? std::thread::hardware_concurrency()
+                                  : options.thread_count);
+    pool = own_pool.get();
+  }
+  {
+    std::mutex done_mutex{};
+    std::condition_variable strip_done{};
+    int remaining{strip_count};
+    for (int strip = 0; strip != strip_count; ++strip) {
+      pool->submit([&, strip]() {
+        if (!failed) {
+          try {
+            strips[strip] = detectStrip(source, strip, strip_rows, halo,
+                                        compute_mask, morphology);
+          } catch (...) {
+            failed = true;
+          }
+        }
+        // Notified under the lock, the waiter may return right after.
+        std::lock_guard<std::mutex> lock{done_mutex};
+        --remaining;
+        strip_done.notify_all();
+      });
+    }
+    // A shared pool may be running other callers' tasks too, so only this
+    // call's strips are waited for.
+    std::unique_lock<std::mutex> lock{done_mutex};
+    strip_done.wait(lock, [&remaining]() { return remaining == 0; });
+  }
+  if (failed) {
+    throw std::runtime_error("Cannot read image rows");
+  }
+  PROFILE_SCOPE("stitch strips");
+
+  std::vector<Contour> contours{};
+  std::vector<Piece> pieces{};
+  std::vector<std::vector<int>> pieces_by_strip(strip_count);
+  for (StripResult &result : strips) {
+    std::move(result.closed.begin(), result.closed.end(),
+              std::back_inserter(contours));
+    for (Piece &piece : result.open) {
+      pieces_by_strip[piece.strip].push_back(static_cast<int>(pieces.size()));
+      pieces.push_back(std::move(piece));
+    }
+  }
+  strips.clear();
+
+  std::vector<int> parent(pieces.size());
+  std::iota(parent.begin(), parent.end(), 0);
+  for (int strip = 0; strip + 1 < strip_count; ++strip) {
+    linkAcrossCut(pieces, pieces_by_strip[strip], pieces_by_strip[strip + 1],
+                  (strip + 1) * strip_rows, source.width, parent);
+  }
+
+  std::vector<std::vector<int>> groups(pieces.size());
+  for (int i = 0; i != static_cast<int>(pieces.size()); ++i) {
+    groups[findRoot(parent, i)].push_back(i);
+  }
+
+  // Only contours joined across a cut can enclose contours found in another
+  // strip; the rest were already filtered by their strip's RETR_EXTERNAL.
+  std::vector<Contour> joined_across{};
+  for (const std::vector<int> &group : groups) {
+    if (group.empty()) {
+      continue;
+    }
+    cv::Rect bbox{pieces[group.front()].bbox};
+    for (int i : group) {
+      bbox |= pieces[i].bbox;
+    }
+    cv::Mat mask = cv::Mat::zeros(bbox.height, bbox.width, CV_8UC1);
+    for (int i : group) {
+      cv::Mat target{mask(pieces[i].bbox - bbox.tl())};
+      cv::bitwise_or(target, pieces[i].filled, target);
+    }
+    std::vector<Contour> joined{};
+    cv::findContours(mask, joined, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE,
+                     bbox.tl());
+    std::move(joined.begin(), joined.end(),
+              std::back_inserter(group.size() == 1 ? contours
+                                                   : joined_across));
+  }
+  size_t first_joined{contours.size()};
+  std::move(joined_across.begin(), joined_across.end(),
+            std::back_inserter(contours));
+  ContourStore candidates{contours};
+  contours.clear();
+
+  std::vector<size_t> kept{};
+  kept.reserve(candidates.size());
+  for (size_t i = 0; i != candidates.size(); ++i) {
+    bool enclosed{false};
+    for (size_t j = first_joined; j != candidates.size() && !enclosed; ++j) {
+      // The first point of another component is never on this contour, so
+      // the test is strictly inside or outside.
+      enclosed = j != i &&
+                 (candidates.bbox(i) & candidates.bbox(j)) ==
+                     candidates.bbox(i) &&
+                 cv::pointPolygonTest(candidates[j].mat(),
+                                      candidates[i].front(), false) > 0;
+    }
+    if (!enclosed) {
+      kept.push_back(i);
+    }
+  }
+
+  // cv::findContours lists contours by their first point, the topmost
+  // leftmost one, in reverse raster order.
+  std::sort(kept.begin(), kept.end(), [&candidates](size_t a, size_t b) {
+    const cv::Point &first_a{candidates[a].front()};
+    const cv::Point &first_b{candidates[b].front()};
+    return first_a.y != first_b.y ? first_a.y > first_b.y
+                                  : first_a.x > first_b.x;
+  });
+
+  ContourStore result{};
+  result.reserve(kept.size(), candidates.pointCount());
+  for (size_t i : kept) {
+    result.append(candidates, i);
+  }
+
+  return result;
+}
+
+/**
+ * @brief Tiled counterpart of getContourVector, for images too large to
+ *        process whole.
+ */
+ContourStore
+getContourVectorTiled(const StripSource &source, const TileOptions &options) {
+  return detectTiled(source, options, RedPreset::computeMask,
+                     RedPreset::kMorphology);
+}
+
+/**
+ * @brief Same as getContourVector, with the image split into bands detected
+ *        on a pool shared by all calls, for the latency of a single image.
+ *        Not meant for callers already running one detection per core.
+ *
+ * @param rgb Image to process;
+ * @param thread_count Number of bands, 0 means one per core.
+ * @return The contours with their features.
+ */
+ContourStore
+getContourVectorBanded(const cv::Mat &rgb, size_t thread_count) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // Every band reads the halo twice over; thinner bands than that cost more
+  // than they save.
+  int min_rows{4 * morphologyHalo(RedPreset::kMorphology)};
+  int strip_rows{std::max(
+      min_rows, (rgb.rows + static_cast<int>(thread_count) - 1) /
+                    static_cast<int>(thread_count))};
+  if (thread_count == 1 || strip_rows >= rgb.rows) {
+    return getContourVector(rgb);
+  }
+
+  return getContourVectorTiled(
+      matStripSource(rgb), TileOptions{strip_rows, thread_count, &bandPool()});
+}
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <vector>
+
+#include "contour_detection.h"
+#include "pyramid_detection.h"
+#include "region_detection.h"
+#include "tiled_detection.h"
+
+// Checks that the detection variants give the same contours as detecting on
+// the whole image with getContourVector, point for point. The images hold
+// objects crossing the borders the variants cut the image at and objects
+// touching the image's edges, as well as randomly placed ones.
+
+namespace {
+using Contour = std::vector<cv::Point>;
+
+const cv::Scalar kRed{220, 30, 30};
+const cv::Scalar kGray{128, 128, 128};
+
+// Gray RGB image with red ellipses at reproducible places, 4:3.
+cv::Mat makeSyntheticImage(int width, int object_count) {
+  int height{width * 3 / 4};
+  cv::Mat img(height, width, CV_8UC3, cv::Scalar(128, 128, 128));
+  cv::RNG rng{12345};
+  int max_axis{std::max(5, width / 40)};
+  for (int i = 0; i != object_count; ++i) {
+    cv::Point center{rng.uniform(0, width), rng.uniform(0, height)};
+    cv::Size axes{rng.uniform(4, max_axis), rng.uniform(4, max_axis)};
+    cv::ellipse(img, center, axes, rng.uniform(0, 180), 0, 360, kRed,
+                cv::FILLED);
+  }
+
+  return img;
+}
+
+// Objects spanning many rows, joined only below their top, with holes and
+// with objects in their holes, close enough for the closing to join them,
+// and cut by the image's edges.
+void addAwkwardObjects(cv::Mat &img) {
+  // A bar through every strip.
+  cv::rectangle(img, cv::Rect(20, 0, 8, img.rows), kRed, cv::FILLED);
+  // A U, whose arms are separate contours until its bottom.
+  cv::rectangle(img, cv::Rect(60, 30, 10, 200), kRed, cv::FILLED);
+  cv::rectangle(img, cv::Rect(110, 30, 10, 200), kRed, cv::FILLED);
+  cv::rectangle(img, cv::Rect(60, 220, 60, 10), kRed, cv::FILLED);
+  // A ring with a disk in its hole, which external contours leave out.
+  cv::circle(img, cv::Point(260, 200), 90, kRed, 12);
+  cv::circle(img, cv::Point(260, 200), 30, kRed, cv::FILLED);
+  // A thick diagonal, connected across cuts only through its corners.
+  cv::line(img, cv::Point(380, 20), cv::Point(560, 300), kRed, 9);
+  // Two blocks a few rows apart, joined by the closing.
+  cv::rectangle(img, cv::Rect(400, 330, 80, 40), kRed, cv::FILLED);
+  cv::rectangle(img, cv::Rect(400, 374, 80, 40), kRed, cv::FILLED);
+  // Objects cut by every edge and corner.
+  cv::circle(img, cv::Point(0, 0), 25, kRed, cv::FILLED);
+  cv::circle(img, cv::Point(img.cols - 1, img.rows / 2), 30, kRed,
+             cv::FILLED);
+  cv::circle(img, cv::Point(img.cols / 2, img.rows - 1), 30, kRed,
+             cv::FILLED);
+  cv::circle(img, cv::Point(img.cols - 1, img.rows - 1), 20, kRed,
+             cv::FILLED);
+  cv::rectangle(img, cv::Rect(150, 0, 30, 12), kRed, cv::FILLED);
+}
+
+cv::Mat makeTestImage(int width, int object_count) {
+  cv::Mat img{makeSyntheticImage(width, object_count)};
+  addAwkwardObjects(img);
+
+  return img;
+}
+
+std::vector<Contour> toVectors(const ContourStore &store) {
+  std::vector<Contour> contours{};
+  for (size_t i = 0; i != store.size(); ++i) {
+    contours.emplace_back(store[i].begin(), store[i].end());
+  }
+
+  return contours;
+}
+
+bool pointLess(const cv::Point &a, const cv::Point &b) {
+  return a.y != b.y ? a.y < b.y : a.x < b.x;
+}
+
+/**
+ * @brief Compares the contours of a variant with those of whole-image
+ *        detection and reports the outcome.
+ *
+ * @param name Variant, for the report;
+ * @param expected Contours of whole-image detection;
+ * @param actual Contours of the variant;
+ * @param ordered Whether the order has to be the same too.
+ */
+bool sameContours(const std::string &name, const ContourStore &expected,
+                  const ContourStore &actual, bool ordered) {
+  std::vector<Contour> want{toVectors(expected)};
+  std::vector<Contour> got{toVectors(actual)};
+  if (!ordered) {
+    auto contour_less = [](const Contour &a, const Contour &b) {
+      return std::lexicographical_compare(a.begin(), a.end(), b.begin(),
+                                          b.end(), pointLess);
+    };
+    std::sort(want.begin(), want.end(), contour_less);
+    std::sort(got.begin(), got.end(), contour_less);
+  }
+
+  std::cout << name << ": ";
+  if (want.size() != got.size()) {
+    std::cout << got.size() << " contours instead of " << want.size()
+              << "\n";
+    return false;
+  }
+  for (size_t i = 0; i != want.size(); ++i) {
+    if (want[i] != got[i]) {
+      std::cout << "contour " << i << " differs\n";
+      return false;
+    }
+  }
+  std::cout << want.size() << " contours match\n";
+
+  return true;
+}
+
+bool checkTiled(const cv::Mat &img, const ContourStore &expected) {
+  bool ok{true};
+  // Strips thinner than the morphology halo as well as thicker ones.
+  for (int strip_rows : {7, 16, 45, 128}) {
+    ok &= sameContours("tiled, " + std::to_string(strip_rows) + " rows",
+                       expected,
+                       getContourVectorTiled(matStripSource(img),
+                                             TileOptions{strip_rows, 4}),
+                       true);
+  }
+  for (size_t bands : {2, 3, 5}) {
+    ok &= sameContours("banded, " + std::to_string(bands) + " bands",
+                       expected, getContourVectorBanded(img, bands), true);
+  }
+
+  return ok;
+}
+
+/**
+ * @brief Detects a changed image again within the changed rectangle and
+ *        compares the result with whole-image detection. The order differs
+ *        by design, but contours kept from before must keep their points.
+ */
+bool checkRegion(const std::string &name, const cv::Mat &before,
+                 const cv::Mat &after, const cv::Rect &dirty) {
+  ContourStore previous{getContourVector(before)};
+  RegionDetection region{getContourVectorRegion(after, previous, dirty)};
+  bool ok{sameContours("region, " + name, getContourVector(after),
+                       region.contours, false)};
+
+  std::vector<Contour> previous_contours{toVectors(previous)};
+  std::vector<Contour> region_contours{toVectors(region.contours)};
+  for (size_t i = 0; i != previous_contours.size(); ++i) {
+    int number{region.renumbered[i]};
+    if (number >= 0 && previous_contours[i] != region_contours[number]) {
+      std::cout << "region, " << name << ": contour " << i
+                << " renumbered to " << number << " differs\n";
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+// Changes the image one step after another, every step checked from the
+// image of the previous one.
+bool checkRegions(const cv::Mat &img) {
+  bool ok{true};
+  cv::Mat before{img.clone()};
+  auto step = [&](const std::string &name, const cv::Rect &dirty,
+                  const cv::Scalar &color) {
+    cv::Mat after{before.clone()};
+    cv::rectangle(after, dirty, color, cv::FILLED);
+    ok &= checkRegion(name, before, after, dirty);
+    before = after;
+  };
+
+  step("new object", cv::Rect(580, 380, 30, 30), kRed);
+  // The U falls apart into its arms.
+  step("split object", cv::Rect(80, 215, 20, 20), kGray);
+  // The bar, the U and the ring become one object reaching far beyond the
+  // change.
+  step("joined objects", cv::Rect(28, 195, 150, 10), kRed);
+  step("object in a hole", cv::Rect(250, 140, 20, 20), kRed);
+  step("removed corner", cv::Rect(0, 0, 30, 30), kGray);
+  step("edge", cv::Rect(img.cols - 40, 100, 40, 60), kRed);
+
+  return ok;
+}
+
+bool checkPyramid(const std::string &name, const cv::Mat &img) {
+  ContourStore expected{getContourVector(img)};
+  bool ok{true};
+  // A share of 1 refines regions however much of the image they cover,
+  // rather than falling back to whole-image detection.
+  for (int block_size : {4, 8, 16}) {
+    for (double share : {0.5, 1.0}) {
+      PyramidOptions options{block_size, share};
+      ok &= sameContours("pyramid, " + name + ", " +
+                             std::to_string(block_size) + " px blocks, " +
+                             (share == 1.0 ? "all regions" : "default share"),
+                         expected, getContourVectorPyramid(img, options),
+                         true);
+    }
+  }
+
+  return ok;
+}
+} // namespace
+
+int main() {
+  cv::Mat img{makeTestImage(640, 64)};
+  ContourStore expected{getContourVector(img)};
+
+  bool tiled_ok{checkTiled(img, expected)};
+  bool region_ok{checkRegions(img)};
+  // Pyramid detection pays off with few objects, where most blocks are
+  // empty.
+  bool dense_ok{checkPyramid("dense", img)};
+  bool sparse_ok{checkPyramid("sparse", makeTestImage(1600, 16))};
+
+  return tiled_ok && region_ok && dense_ok && sparse_ok ? EXIT_SUCCESS
+                                                        : EXIT_FAILURE;
+}